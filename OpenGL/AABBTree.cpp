@@ -0,0 +1,429 @@
+#include <glm/glm/glm.hpp>
+#include <algorithm>
+
+#include "AABBTree.h"
+#include "RigidBody.h"
+#include "JobSystem.h"
+
+// nodes per block when finding pairs
+static const int QUERY_BLOCK_SIZE = 256;
+
+AABBTree::AABBTree()
+{
+	m_root = -1;
+	m_freeList = -1;
+}
+
+AABBTree::~AABBTree()
+{
+	for (auto block : m_blocks)
+		delete block;
+}
+
+AABB AABBTree::Combine(const AABB& a, const AABB& b)
+{
+	return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+}
+
+float AABBTree::Perimeter(const AABB& a)
+{
+	return 2.0f * ((a.max.x - a.min.x) + (a.max.y - a.min.y));
+}
+
+bool AABBTree::Contains(const AABB& outer, const AABB& inner)
+{
+	return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+
+int AABBTree::AllocateNode()
+{
+	if (m_freeList == -1)
+	{
+		m_nodes.push_back(Node());
+		m_nodes.back().parent = m_freeList;
+		m_freeList = (int)m_nodes.size() - 1;
+	}
+
+	// free nodes are chained through their parent index
+	int node = m_freeList;
+	m_freeList = m_nodes[node].parent;
+	m_nodes[node].parent = -1;
+	m_nodes[node].child1 = -1;
+	m_nodes[node].child2 = -1;
+	m_nodes[node].height = 0;
+	m_nodes[node].body = nullptr;
+	return node;
+}
+
+void AABBTree::FreeNode(int node)
+{
+	m_nodes[node].parent = m_freeList;
+	m_nodes[node].height = -1;
+	m_nodes[node].body = nullptr;
+	m_freeList = node;
+}
+
+void AABBTree::AddBody(RigidBody* body)
+{
+	int leaf = AllocateNode();
+	glm::vec2 fat(margin, margin);
+	m_nodes[leaf].body = body;
+	m_nodes[leaf].tight = body->GetAABB();
+	m_nodes[leaf].aabb = { m_nodes[leaf].tight.min - fat, m_nodes[leaf].tight.max + fat };
+	InsertLeaf(leaf);
+	body->proxy = leaf;
+}
+
+void AABBTree::RemoveBody(RigidBody* body)
+{
+	RemoveLeaf(body->proxy);
+	FreeNode(body->proxy);
+	body->proxy = -1;
+}
+
+void AABBTree::InsertLeaf(int leaf)
+{
+	if (m_root == -1)
+	{
+		m_root = leaf;
+		m_nodes[leaf].parent = -1;
+		return;
+	}
+
+	// walk down the tree picking whichever child would grow the least by adding the leaf
+	AABB leafAABB = m_nodes[leaf].aabb;
+	int index = m_root;
+	while (!m_nodes[index].IsLeaf())
+	{
+		int child1 = m_nodes[index].child1;
+		int child2 = m_nodes[index].child2;
+
+		float area = Perimeter(m_nodes[index].aabb);
+		float combinedArea = Perimeter(Combine(m_nodes[index].aabb, leafAABB));
+
+		// cost of making a new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+		// minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float cost1 = Perimeter(Combine(leafAABB, m_nodes[child1].aabb));
+		if (!m_nodes[child1].IsLeaf())
+			cost1 -= Perimeter(m_nodes[child1].aabb);
+		cost1 += inheritanceCost;
+
+		float cost2 = Perimeter(Combine(leafAABB, m_nodes[child2].aabb));
+		if (!m_nodes[child2].IsLeaf())
+			cost2 -= Perimeter(m_nodes[child2].aabb);
+		cost2 += inheritanceCost;
+
+		if (cost < cost1 && cost < cost2)
+			break;
+
+		index = cost1 < cost2 ? child1 : child2;
+	}
+
+	// make a new parent for the sibling and the leaf
+	int sibling = index;
+	int oldParent = m_nodes[sibling].parent;
+	int newParent = AllocateNode();
+	m_nodes[newParent].parent = oldParent;
+	m_nodes[newParent].aabb = Combine(leafAABB, m_nodes[sibling].aabb);
+	m_nodes[newParent].height = m_nodes[sibling].height + 1;
+	m_nodes[newParent].child1 = sibling;
+	m_nodes[newParent].child2 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent == -1)
+		m_root = newParent;
+	else if (m_nodes[oldParent].child1 == sibling)
+		m_nodes[oldParent].child1 = newParent;
+	else
+		m_nodes[oldParent].child2 = newParent;
+
+	// walk back up fixing heights and bounds
+	index = m_nodes[leaf].parent;
+	while (index != -1)
+	{
+		index = Balance(index);
+
+		int child1 = m_nodes[index].child1;
+		int child2 = m_nodes[index].child2;
+		m_nodes[index].height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
+		m_nodes[index].aabb = Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+
+		index = m_nodes[index].parent;
+	}
+}
+
+void AABBTree::RemoveLeaf(int leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = -1;
+		return;
+	}
+
+	// the sibling takes the parent's place
+	int parent = m_nodes[leaf].parent;
+	int grandParent = m_nodes[parent].parent;
+	int sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+	if (grandParent == -1)
+	{
+		m_root = sibling;
+		m_nodes[sibling].parent = -1;
+		FreeNode(parent);
+		return;
+	}
+
+	if (m_nodes[grandParent].child1 == parent)
+		m_nodes[grandParent].child1 = sibling;
+	else
+		m_nodes[grandParent].child2 = sibling;
+	m_nodes[sibling].parent = grandParent;
+	FreeNode(parent);
+
+	int index = grandParent;
+	while (index != -1)
+	{
+		index = Balance(index);
+
+		int child1 = m_nodes[index].child1;
+		int child2 = m_nodes[index].child2;
+		m_nodes[index].aabb = Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+		m_nodes[index].height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
+
+		index = m_nodes[index].parent;
+	}
+}
+
+// if one side of node a is more than one level taller than the other, rotate its taller child up
+// into a's place. Returns the index of the node now at the top of this subtree.
+int AABBTree::Balance(int a)
+{
+	Node& A = m_nodes[a];
+	if (A.IsLeaf() || A.height < 2)
+		return a;
+
+	int b = A.child1;
+	int c = A.child2;
+	int balance = m_nodes[c].height - m_nodes[b].height;
+
+	// rotate c up, or b up
+	int up = -1, other = -1;
+	if (balance > 1)
+	{
+		up = c;
+		other = b;
+	}
+	else if (balance < -1)
+	{
+		up = b;
+		other = c;
+	}
+	else
+	{
+		return a;
+	}
+
+	Node& U = m_nodes[up];
+	int f = U.child1;
+	int g = U.child2;
+
+	// swap a and up
+	U.child1 = a;
+	U.parent = A.parent;
+	A.parent = up;
+
+	if (U.parent != -1)
+	{
+		if (m_nodes[U.parent].child1 == a)
+			m_nodes[U.parent].child1 = up;
+		else
+			m_nodes[U.parent].child2 = up;
+	}
+	else
+	{
+		m_root = up;
+	}
+
+	// the taller grandchild stays with up, the shorter one goes down to a
+	int keep = f, give = g;
+	if (m_nodes[f].height < m_nodes[g].height)
+	{
+		keep = g;
+		give = f;
+	}
+
+	U.child2 = keep;
+	if (up == c)
+		A.child2 = give;
+	else
+		A.child1 = give;
+	m_nodes[give].parent = a;
+
+	A.aabb = Combine(m_nodes[other].aabb, m_nodes[give].aabb);
+	A.height = 1 + std::max(m_nodes[other].height, m_nodes[give].height);
+	U.aabb = Combine(A.aabb, m_nodes[keep].aabb);
+	U.height = 1 + std::max(A.height, m_nodes[keep].height);
+
+	return up;
+}
+
+void AABBTree::FindPairs(std::vector<BroadphasePair>& pairs)
+{
+	int numNodes = (int)m_nodes.size();
+	int numBlocks = (numNodes + QUERY_BLOCK_SIZE - 1) / QUERY_BLOCK_SIZE;
+	while ((int)m_blocks.size() < numBlocks)
+		m_blocks.push_back(new QueryBlock());
+
+	auto forEachBlock = [&](const std::function<void(int)>& job)
+	{
+		if (jobs)
+			jobs->ParallelFor(numBlocks, job);
+		else
+		{
+			for (int b = 0; b < numBlocks; b++)
+				job(b);
+		}
+	};
+
+	// get the bodies' new bounds. Each leaf only touches itself, so this can be done in parallel.
+	// Sleeping and fixed bodies haven't moved
+	forEachBlock([&](int b)
+	{
+		int last = std::min(numNodes, (b + 1) * QUERY_BLOCK_SIZE);
+		for (int i = b * QUERY_BLOCK_SIZE; i < last; i++)
+		{
+			if (m_nodes[i].height == 0 && m_nodes[i].body->IsAwake())
+				m_nodes[i].tight = m_nodes[i].body->GetAABB();
+		}
+	});
+
+	// refit the leaves, only touching the tree for bodies that have left their fat box
+	glm::vec2 fat(margin, margin);
+	for (int i = 0; i < numNodes; i++)
+	{
+		Node& node = m_nodes[i];
+		if (node.height != 0)
+			continue;
+		if (!Contains(node.aabb, node.tight))
+		{
+			RemoveLeaf(i);
+			m_nodes[i].aabb = { m_nodes[i].tight.min - fat, m_nodes[i].tight.max + fat };
+			InsertLeaf(i);
+		}
+	}
+
+	// the tree doesn't change from here on, so blocks of leaves can query it at the same time.
+	// Joining the blocks' results back up in order gives exactly the same pairs as doing it all in one go.
+	forEachBlock([&](int b)
+	{
+		QueryBlock& block = *m_blocks[b];
+		block.pairs.clear();
+		int last = std::min(numNodes, (b + 1) * QUERY_BLOCK_SIZE);
+		for (int i = b * QUERY_BLOCK_SIZE; i < last; i++)
+		{
+			if (m_nodes[i].height == 0 && m_nodes[i].body->IsAwake())
+				QueryLeaf(i, block.stack, block.pairs);
+		}
+	});
+
+	for (int b = 0; b < numBlocks; b++)
+		pairs.insert(pairs.end(), m_blocks[b]->pairs.begin(), m_blocks[b]->pairs.end());
+}
+
+// queries the tree with an awake leaf. Only sleeping and fixed leaves don't query, so pairs against them are
+// always reported, and pairs against other awake leaves only against higher numbered ones so each comes up once
+void AABBTree::QueryLeaf(int leaf, std::vector<int>& stack, std::vector<BroadphasePair>& pairs)
+{
+	const AABB& tight = m_nodes[leaf].tight;
+	RigidBody* body = m_nodes[leaf].body;
+
+	stack.clear();
+	stack.push_back(m_root);
+	while (stack.size() > 0)
+	{
+		int index = stack.back();
+		stack.pop_back();
+
+		const Node& node = m_nodes[index];
+		if (!node.aabb.Overlaps(tight))
+			continue;
+
+		if (node.IsLeaf())
+		{
+			if ((index > leaf || !node.body->IsAwake()) && node.tight.Overlaps(tight))
+				pairs.push_back(MakePair(body, node.body));
+		}
+		else
+		{
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+}
+
+void AABBTree::Query(const AABB& aabb, std::vector<RigidBody*>& results)
+{
+	if (m_root == -1)
+		return;
+
+	m_stack.clear();
+	m_stack.push_back(m_root);
+	while (m_stack.size() > 0)
+	{
+		const Node& node = m_nodes[m_stack.back()];
+		m_stack.pop_back();
+
+		if (!node.aabb.Overlaps(aabb))
+			continue;
+
+		if (node.IsLeaf())
+		{
+			results.push_back(node.body);
+		}
+		else
+		{
+			m_stack.push_back(node.child1);
+			m_stack.push_back(node.child2);
+		}
+	}
+}
+
+RigidBody* AABBTree::RayCast(glm::vec2 start, glm::vec2 end, float& fraction)
+{
+	RigidBody* hit = nullptr;
+	fraction = 1;
+	if (m_root == -1)
+		return hit;
+
+	m_stack.clear();
+	m_stack.push_back(m_root);
+	while (m_stack.size() > 0)
+	{
+		const Node& node = m_nodes[m_stack.back()];
+		m_stack.pop_back();
+
+		// only look at nodes the ray reaches before the closest hit so far
+		float t;
+		if (!RayHitsAABB(node.aabb, start, end, fraction, t))
+			continue;
+
+		if (node.IsLeaf())
+		{
+			if (node.body->RayCast(start, end, t) && t < fraction)
+			{
+				fraction = t;
+				hit = node.body;
+			}
+		}
+		else
+		{
+			m_stack.push_back(node.child1);
+			m_stack.push_back(node.child2);
+		}
+	}
+	return hit;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include "Broadphase.h"
+
+// dynamic bounding volume hierarchy. Each body is a leaf holding a "fat" AABB that's bigger than the body
+// by a margin, so the tree only needs changing when a body moves out of its fat box. Leaves are inserted
+// where they grow the tree the least and the tree is kept balanced with AVL style rotations, so pair
+// finding, picking and ray casts are all O(log n) per body no matter how mixed the body sizes are.
+class AABBTree : public Broadphase
+{
+public:
+	AABBTree();
+	virtual ~AABBTree();
+
+	virtual BroadphaseType GetType() { return AABB_TREE; }
+
+	virtual void AddBody(RigidBody* body);
+	virtual void RemoveBody(RigidBody* body);
+	virtual void FindPairs(std::vector<BroadphasePair>& pairs);
+
+	virtual void Query(const AABB& aabb, std::vector<RigidBody*>& results);
+	virtual RigidBody* RayCast(glm::vec2 start, glm::vec2 end, float& fraction);
+
+	int GetHeight() { return m_root == -1 ? 0 : m_nodes[m_root].height; }
+
+	// how much bigger than the body the fat AABBs are
+	float margin = 0.2f;
+
+private:
+	struct Node
+	{
+		AABB aabb;
+		// the body's real bounds, only used for leaves
+		AABB tight;
+		RigidBody* body;
+		int parent;
+		int child1;
+		int child2;
+		// leaves are 0, free nodes are -1
+		int height;
+
+		bool IsLeaf() const { return child1 == -1; }
+	};
+
+	int AllocateNode();
+	void FreeNode(int node);
+
+	void QueryLeaf(int leaf, std::vector<int>& stack, std::vector<BroadphasePair>& pairs);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	int Balance(int index);
+
+	static AABB Combine(const AABB& a, const AABB& b);
+	static float Perimeter(const AABB& a);
+	static bool Contains(const AABB& outer, const AABB& inner);
+
+	std::vector<Node> m_nodes;
+	int m_root;
+	int m_freeList;
+
+	std::vector<int> m_stack;
+
+	// pair finding is split into blocks of nodes, each with its own results so they can run on different threads
+	struct QueryBlock
+	{
+		std::vector<int> stack;
+		std::vector<BroadphasePair> pairs;
+	};
+	std::vector<QueryBlock*> m_blocks;
+};
\ No newline at end of file
@@ -0,0 +1,345 @@
+// physics_bench: steps the built in scenes and some scaled up ones headless, and reports how fast as JSON.
+// Built by physics_bench.vcxproj, not the main project.
+//
+//   physics_bench [-frames n] [-threads n] [-scene name] [-simd scalar|sse2|avx2] [-out file.json]
+//   physics_bench -replay file [-threads n] [-simd ...] [-out file.json]
+//   physics_bench -rollouts n [-frames n] [-threads n] [-scene name] [-simd ...] [-out file.json]
+//
+// The JSON goes to stdout unless -out is given, with a summary table on stderr. -scene can also be a scene file
+// (see SceneFile), and how long it takes to load is in the JSON. -replay plays back a recording made in the app
+// instead, checking it comes out the same step for step. -rollouts runs n copies of one scene side by side (see
+// Rollouts), sweeping every body's restitution from 0 to 1 across them, and reports each one's final energy.
+
+#include <glm/glm/glm.hpp>
+#include <chrono>
+#include <functional>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "PhysicsWorld.h"
+#include "Scenes.h"
+#include "Replay.h"
+#include "SceneFile.h"
+#include "Rollouts.h"
+
+struct BenchScene
+{
+	const char* name;
+	std::function<void(PhysicsWorld*)> reset;
+	// has a player driven lander to feed input to
+	bool lander;
+};
+
+static const BenchScene s_scenes[] =
+{
+	{ "pool", ResetPool, false },
+	{ "lander", ResetLunarLander, true },
+	{ "springs", ResetSprings, false },
+	{ "basic", ResetBasic, false },
+	{ "twoboxes", ResetTwoBoxes, false },
+	{ "rain_1000", [](PhysicsWorld* world) { ResetRain(world, 1000); }, false },
+	{ "rain_10000", [](PhysicsWorld* world) { ResetRain(world, 10000); }, false },
+	{ "pyramid_20", [](PhysicsWorld* world) { ResetPyramid(world, 20); }, false },
+	{ "pyramid_50", [](PhysicsWorld* world) { ResetPyramid(world, 50); }, false },
+	{ "cloth_32", [](PhysicsWorld* world) { ResetCloth(world, 32, 32); }, false },
+	{ "cloth_200x50", [](PhysicsWorld* world) { ResetCloth(world, 200, 50); }, false },
+};
+
+static const int NUM_SCENES = sizeof(s_scenes) / sizeof(s_scenes[0]);
+static const char* s_simdNames[] = { "scalar", "sse2", "avx2" };
+
+// the same burns every run: a second of nothing, then left, right and both thrusters for a second each
+static unsigned int LanderInput(int frame)
+{
+	static const unsigned int script[] =
+	{
+		0,
+		PhysicsWorld::INPUT_THRUST_LEFT,
+		PhysicsWorld::INPUT_THRUST_RIGHT,
+		PhysicsWorld::INPUT_THRUST_LEFT | PhysicsWorld::INPUT_THRUST_RIGHT,
+	};
+	return script[(frame / 60) % 4];
+}
+
+static void WritePhases(FILE* out, Profiler& profiler)
+{
+	fprintf(out, "      \"phases\": {");
+	for (int phase = 0; phase < Profiler::NUM_PHASES; phase++)
+	{
+		Profiler::Stats stats = profiler.GetStats(phase);
+		fprintf(out, "%s\n        \"%s\": { \"totalMs\": %.3f, \"min\": %.4f, \"avg\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+			phase == 0 ? "" : ",", Profiler::PhaseName(phase), stats.total, stats.min, stats.avg, stats.p99, stats.max);
+	}
+	fprintf(out, "\n      }\n");
+}
+
+static void RunScene(const BenchScene& scene, int frames, int threads, Integrator::InstructionSet simd, FILE* out, bool first)
+{
+	PhysicsWorld world;
+	world.numThreads = threads;
+	world.instructionSet = simd;
+	auto loadStart = std::chrono::steady_clock::now();
+	scene.reset(&world);
+	double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+
+	long long contacts = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		if (scene.lander)
+			world.input = LanderInput(frame);
+		world.Step();
+		world.profiler.EndFrame();
+		contacts += world.numContacts;
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	int bodies = world.bodies.Count();
+	double stepsPerSec = frames / (ms / 1000.0);
+	double nsPerBodyStep = bodies > 0 ? ms * 1e6 / ((double)frames * bodies) : 0;
+	float k, g, r;
+	float energy = world.getEnergy(k, g, r);
+
+	fprintf(stderr, "%-12s %7d bodies %10.1f steps/s %9.3f ms/step %8.1f ns/body/step\n",
+		scene.name, bodies, stepsPerSec, ms / frames, nsPerBodyStep);
+
+	fprintf(out, "%s\n    {\n", first ? "" : ",");
+	fprintf(out, "      \"name\": \"%s\",\n", scene.name);
+	fprintf(out, "      \"bodies\": %d,\n", bodies);
+	fprintf(out, "      \"awake\": %d,\n", world.bodies.AwakeCount());
+	fprintf(out, "      \"loadMs\": %.3f,\n", loadMs);
+	fprintf(out, "      \"totalMs\": %.3f,\n", ms);
+	fprintf(out, "      \"stepsPerSec\": %.1f,\n", stepsPerSec);
+	fprintf(out, "      \"msPerStep\": %.4f,\n", ms / frames);
+	fprintf(out, "      \"nsPerBodyStep\": %.2f,\n", nsPerBodyStep);
+	fprintf(out, "      \"contactsPerStep\": %.1f,\n", (double)contacts / frames);
+	// so a change that makes a scene faster by making it do something different shows up
+	fprintf(out, "      \"finalEnergy\": %.4f,\n", energy);
+	WritePhases(out, world.profiler);
+	fprintf(out, "    }");
+}
+
+// plays the whole recording back, carrying on past a mismatch so the timings cover all of it.
+// Returns the first step that didn't match, or -1
+static int RunReplay(Replay& replay, const char* path, int threads, Integrator::InstructionSet simd, FILE* out)
+{
+	PhysicsWorld world;
+	world.numThreads = threads;
+	world.instructionSet = simd;
+	replay.Restart(world);
+
+	int firstMismatch = -1;
+	auto start = std::chrono::steady_clock::now();
+	while (replay.StepsPlayed() < replay.NumSteps())
+	{
+		if (!replay.PlayStep(world) && firstMismatch < 0)
+			firstMismatch = replay.StepsPlayed() - 1;
+		world.profiler.EndFrame();
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	int steps = replay.NumSteps();
+	fprintf(stderr, "%s: %s, %d steps %10.1f steps/s %9.3f ms/step\n", path, replay.header.scene, steps, steps / (ms / 1000.0), ms / steps);
+	if (firstMismatch >= 0)
+		fprintf(stderr, "diverged from the recording at step %d\n", firstMismatch);
+	else
+		fprintf(stderr, "every step matched the recording\n");
+
+	fprintf(out, "{\n  \"replay\": \"%s\",\n  \"scene\": \"%s\",\n  \"threads\": %d,\n  \"simd\": \"%s\",\n",
+		path, replay.header.scene, threads, s_simdNames[simd]);
+	fprintf(out, "  \"steps\": %d,\n  \"firstMismatch\": %d,\n  \"totalMs\": %.3f,\n  \"stepsPerSec\": %.1f,\n",
+		steps, firstMismatch, ms, steps / (ms / 1000.0));
+	WritePhases(out, world.profiler);
+	fprintf(out, "}\n");
+	return firstMismatch;
+}
+
+// the rollouts share the threads out between them, so threads is how many rollouts run at once
+static void RunRollouts(const BenchScene& scene, int count, int frames, int threads, Integrator::InstructionSet simd, FILE* out)
+{
+	PhysicsWorld world;
+	world.instructionSet = simd;
+	scene.reset(&world);
+
+	Rollouts rollouts;
+	rollouts.numThreads = threads;
+	rollouts.Start(world);
+
+	auto restitution = [count](int i) { return count > 1 ? (float)i / (count - 1) : 0.0f; };
+	auto start = std::chrono::steady_clock::now();
+	rollouts.Run(count, frames, [&](PhysicsWorld& copy, int i)
+	{
+		for (auto& value : copy.bodies.restitution)
+			value = restitution(i);
+	});
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	fprintf(stderr, "%s: %d rollouts of %d steps %10.1f rollouts/s %9.3f ms/rollout\n",
+		scene.name, count, frames, count / (ms / 1000.0), ms / count);
+
+	fprintf(out, "{\n  \"scene\": \"%s\",\n  \"bodies\": %d,\n  \"threads\": %d,\n  \"simd\": \"%s\",\n",
+		scene.name, world.bodies.Count(), threads, s_simdNames[simd]);
+	fprintf(out, "  \"frames\": %d,\n  \"totalMs\": %.3f,\n  \"rolloutsPerSec\": %.1f,\n  \"rollouts\": [",
+		frames, ms, count / (ms / 1000.0));
+	for (int i = 0; i < count; i++)
+	{
+		const Rollouts::Result& result = rollouts.results[i];
+		fprintf(out, "%s\n    { \"restitution\": %.4f, \"finalEnergy\": %.4f, \"hash\": \"%016llx\", \"ms\": %.3f }",
+			i == 0 ? "" : ",", restitution(i), result.energy, result.hash, result.ms);
+	}
+	fprintf(out, "\n  ]\n}\n");
+}
+
+static void Usage()
+{
+	fprintf(stderr, "physics_bench [-frames n] [-threads n] [-scene name|file] [-simd scalar|sse2|avx2] [-out file.json]\n");
+	fprintf(stderr, "physics_bench -replay file [-threads n] [-simd scalar|sse2|avx2] [-out file.json]\n");
+	fprintf(stderr, "physics_bench -rollouts n [-frames n] [-threads n] [-scene name|file] [-simd scalar|sse2|avx2] [-out file.json]\nscenes:");
+	for (int i = 0; i < NUM_SCENES; i++)
+		fprintf(stderr, " %s", s_scenes[i].name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+	int frames = 600;
+	int threads = 0;
+	const char* only = nullptr;
+	const char* outPath = nullptr;
+	const char* replayPath = nullptr;
+	int numRollouts = 0;
+	Integrator::InstructionSet simd = Integrator::Best();
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!value)
+		{
+			Usage();
+			return 1;
+		}
+
+		if (!strcmp(arg, "-frames"))
+			frames = atoi(value);
+		else if (!strcmp(arg, "-threads"))
+			threads = atoi(value);
+		else if (!strcmp(arg, "-scene"))
+			only = value;
+		else if (!strcmp(arg, "-out"))
+			outPath = value;
+		else if (!strcmp(arg, "-replay"))
+			replayPath = value;
+		else if (!strcmp(arg, "-rollouts"))
+			numRollouts = atoi(value);
+		else if (!strcmp(arg, "-simd"))
+		{
+			int set = 0;
+			while (set < 3 && strcmp(value, s_simdNames[set]))
+				set++;
+			if (set == 3 || set > Integrator::Best())
+			{
+				fprintf(stderr, "%s isn't supported here\n", value);
+				return 1;
+			}
+			simd = (Integrator::InstructionSet)set;
+		}
+		else
+		{
+			Usage();
+			return 1;
+		}
+		i++;
+	}
+
+	if (frames <= 0 || numRollouts < 0)
+	{
+		Usage();
+		return 1;
+	}
+
+	Replay replay;
+	if (replayPath)
+	{
+		if (!replay.Load(replayPath))
+		{
+			fprintf(stderr, "couldn't read a recording from %s\n", replayPath);
+			return 1;
+		}
+		PhysicsWorld check;
+		if (!replay.Restart(check))
+		{
+			fprintf(stderr, "%s starts from %s, which isn't a built in scene or a scene file that loads\n", replayPath, replay.header.scene);
+			return 1;
+		}
+	}
+
+	bool found = !only;
+	for (int i = 0; i < NUM_SCENES && !found; i++)
+		found = !strcmp(only, s_scenes[i].name);
+
+	// anything else is taken to be a scene file
+	BenchScene fileScene = { only, [only](PhysicsWorld* world)
+	{
+		SceneFile scene;
+		if (!scene.Load(*world, only))
+			fprintf(stderr, "%s: %s\n", only, scene.Error());
+	}, false };
+	SceneFile scene;
+	if (!found && !scene.Open(only))
+	{
+		fprintf(stderr, "no scene called %s, and %s\n", only, scene.Error());
+		Usage();
+		return 1;
+	}
+	scene.Close();
+
+	FILE* out = outPath ? fopen(outPath, "w") : stdout;
+	if (!out)
+	{
+		fprintf(stderr, "couldn't open %s\n", outPath);
+		return 1;
+	}
+
+	if (replayPath)
+	{
+		int firstMismatch = RunReplay(replay, replayPath, threads, simd, out);
+		if (out != stdout)
+			fclose(out);
+		return firstMismatch < 0 ? 0 : 2;
+	}
+
+	if (numRollouts > 0)
+	{
+		// one scene, the first there'd be if it weren't given
+		const BenchScene* rolloutScene = &s_scenes[0];
+		for (int i = 0; i < NUM_SCENES; i++)
+		{
+			if (only && !strcmp(only, s_scenes[i].name))
+				rolloutScene = &s_scenes[i];
+		}
+		RunRollouts(found ? *rolloutScene : fileScene, numRollouts, frames, threads, simd, out);
+		if (out != stdout)
+			fclose(out);
+		return 0;
+	}
+
+	fprintf(out, "{\n  \"frames\": %d,\n  \"threads\": %d,\n  \"simd\": \"%s\",\n  \"scenes\": [", frames, threads, s_simdNames[simd]);
+	bool first = true;
+	for (int i = 0; i < NUM_SCENES; i++)
+	{
+		if (only && strcmp(only, s_scenes[i].name))
+			continue;
+		RunScene(s_scenes[i], frames, threads, simd, out, first);
+		first = false;
+	}
+	if (first)
+		RunScene(fileScene, frames, threads, simd, out, true);
+	fprintf(out, "\n  ]\n}\n");
+
+	if (out != stdout)
+		fclose(out);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include <glm/glm/glm.hpp>
+#include <math.h>
+#include <algorithm>
+
+#include "BodyStore.h"
+
+int BodyStore::Create(const BodyDef& def, RigidBody* view)
+{
+	int h;
+	if (m_freeHandles.size() > 0)
+	{
+		h = m_freeHandles.back();
+		m_freeHandles.pop_back();
+	}
+	else
+	{
+		h = (int)m_indices.size();
+		m_indices.push_back(-1);
+	}
+	m_indices[h] = Count();
+
+	position.push_back(def.position);
+	velocity.push_back(def.velocity);
+	angle.push_back(def.angle);
+	rotation.push_back(def.rotation);
+	invMass.push_back(def.fixed ? 0 : 1.0f / def.mass);
+	invMoment.push_back(def.fixed ? 0 : 1.0f / def.moment);
+	restitution.push_back(def.restitution);
+	previousPosition.push_back(def.position);
+	previousAngle.push_back(def.angle);
+	flags.push_back((def.fixed ? FIXED : 0) | (def.bullet ? BULLET : 0));
+	sleepTime.push_back(0);
+
+	float cs = cosf(def.angle);
+	float sn = sinf(def.angle);
+	localX.push_back(glm::vec2(cs, sn));
+	localY.push_back(glm::vec2(-sn, cs));
+
+	body.push_back(view);
+	handle.push_back(h);
+
+	// it starts off asleep, then joins the awake bodies if it should be
+	if (def.awake && !def.fixed)
+		Wake(Count() - 1);
+	return h;
+}
+
+void BodyStore::Destroy(int h)
+{
+	// keep the awake bodies together, then move the last body into the hole
+	int index = m_indices[h];
+	if (index < m_numAwake)
+	{
+		Swap(index, m_numAwake - 1);
+		index = --m_numAwake;
+	}
+	Swap(index, Count() - 1);
+
+	position.pop_back();
+	velocity.pop_back();
+	angle.pop_back();
+	rotation.pop_back();
+	invMass.pop_back();
+	invMoment.pop_back();
+	restitution.pop_back();
+	flags.pop_back();
+	sleepTime.pop_back();
+	previousPosition.pop_back();
+	previousAngle.pop_back();
+	localX.pop_back();
+	localY.pop_back();
+	body.pop_back();
+	handle.pop_back();
+
+	m_indices[h] = -1;
+	m_freeHandles.push_back(h);
+}
+
+void BodyStore::Clear()
+{
+	position.clear();
+	velocity.clear();
+	angle.clear();
+	rotation.clear();
+	invMass.clear();
+	invMoment.clear();
+	restitution.clear();
+	flags.clear();
+	sleepTime.clear();
+	previousPosition.clear();
+	previousAngle.clear();
+	localX.clear();
+	localY.clear();
+	body.clear();
+	handle.clear();
+	m_indices.clear();
+	m_freeHandles.clear();
+	m_numAwake = 0;
+}
+
+void BodyStore::Reserve(int count)
+{
+	position.reserve(count);
+	velocity.reserve(count);
+	angle.reserve(count);
+	rotation.reserve(count);
+	invMass.reserve(count);
+	invMoment.reserve(count);
+	restitution.reserve(count);
+	flags.reserve(count);
+	sleepTime.reserve(count);
+	previousPosition.reserve(count);
+	previousAngle.reserve(count);
+	localX.reserve(count);
+	localY.reserve(count);
+	body.reserve(count);
+	handle.reserve(count);
+	m_indices.reserve(count);
+}
+
+void BodyStore::Wake(int index)
+{
+	if (flags[index] & (AWAKE | FIXED))
+		return;
+	flags[index] |= AWAKE;
+	sleepTime[index] = 0;
+	Swap(index, m_numAwake++);
+}
+
+void BodyStore::Sleep(int index)
+{
+	if (!(flags[index] & AWAKE))
+		return;
+	flags[index] &= ~AWAKE;
+	velocity[index] = glm::vec2(0, 0);
+	rotation[index] = 0;
+	Swap(index, --m_numAwake);
+}
+
+void BodyStore::Swap(int i, int j)
+{
+	if (i == j)
+		return;
+
+	std::swap(position[i], position[j]);
+	std::swap(velocity[i], velocity[j]);
+	std::swap(angle[i], angle[j]);
+	std::swap(rotation[i], rotation[j]);
+	std::swap(invMass[i], invMass[j]);
+	std::swap(invMoment[i], invMoment[j]);
+	std::swap(restitution[i], restitution[j]);
+	std::swap(flags[i], flags[j]);
+	std::swap(sleepTime[i], sleepTime[j]);
+	std::swap(previousPosition[i], previousPosition[j]);
+	std::swap(previousAngle[i], previousAngle[j]);
+	std::swap(localX[i], localX[j]);
+	std::swap(localY[i], localY[j]);
+	std::swap(body[i], body[j]);
+	std::swap(handle[i], handle[j]);
+	m_indices[handle[i]] = i;
+	m_indices[handle[j]] = j;
+}
\ No newline at end of file
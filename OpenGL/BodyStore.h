@@ -0,0 +1,89 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+#include <vector>
+
+class RigidBody;
+
+// starting state for a rigid body, copied into the store when the body is added to a world
+struct BodyDef
+{
+	glm::vec2 position = glm::vec2(0, 0);
+	glm::vec2 velocity = glm::vec2(0, 0);
+	float angle = 0;
+	float rotation = 0;
+	float mass = 1;
+	float moment = 1;
+	float restitution = 0.95f;
+	bool awake = true;
+	bool fixed = false;
+	// fast moving, so swept against planes and boxes each step rather than just tested where it ends up. Circles only
+	bool bullet = false;
+};
+
+// structure of arrays storage for the state of every rigid body in a world. The arrays are kept dense
+// (removing a body swaps the last one into its place) so the per-step loops just stream through them.
+// Awake bodies are kept at the front, so the bodies that need moving are just [0, AwakeCount()), and sleeping
+// and fixed bodies cost nothing. Bodies are referred to by handles, which stay the same for the life of the body
+// however it moves around in the arrays. Circle and Box are views onto a slot in here.
+class BodyStore
+{
+public:
+	enum BodyFlags
+	{
+		// only ever set on bodies that aren't fixed
+		AWAKE = 1,
+		FIXED = 2,
+		BULLET = 4,
+	};
+
+	int Create(const BodyDef& def, RigidBody* body);
+	void Destroy(int handle);
+	void Clear();
+	// makes room for this many bodies in total, so creating them doesn't keep growing the arrays
+	void Reserve(int count);
+
+	// moves a body in or out of the awake bodies. Sleeping bodies are stopped dead.
+	// Both reorder the arrays, so any indices held on to may now point at different bodies.
+	void Wake(int index);
+	void Sleep(int index);
+
+	int Count() { return (int)position.size(); }
+	int AwakeCount() { return m_numAwake; }
+	int Index(int handle) { return m_indices[handle]; }
+	bool IsValid(int handle) { return handle >= 0 && handle < (int)m_indices.size() && m_indices[handle] >= 0; }
+
+	std::vector<glm::vec2> position;
+	std::vector<glm::vec2> velocity;
+	std::vector<float> angle;
+	std::vector<float> rotation;
+	// fixed bodies have zero inverse mass and moment
+	std::vector<float> invMass;
+	std::vector<float> invMoment;
+	std::vector<float> restitution;
+	std::vector<unsigned char> flags;
+	// how long each body has been moving slowly enough to sleep
+	std::vector<float> sleepTime;
+
+	// where each body was at the start of the last step, for drawing in between steps
+	std::vector<glm::vec2> previousPosition;
+	std::vector<float> previousAngle;
+
+	// local axes, rebuilt from the angle every step
+	std::vector<glm::vec2> localX;
+	std::vector<glm::vec2> localY;
+
+	// the view and handle for each slot
+	std::vector<RigidBody*> body;
+	std::vector<int> handle;
+
+private:
+	friend class Snapshot;
+
+	void Swap(int i, int j);
+
+	int m_numAwake = 0;
+
+	// handle to slot, -1 for free handles
+	std::vector<int> m_indices;
+	std::vector<int> m_freeHandles;
+};
\ No newline at end of file
@@ -1,97 +1,78 @@
-#include <gl_core_4_4.h>
-#include <glm\glm\glm.hpp>
-#include <aie/Gizmos.h>
+#include <glm/glm/glm.hpp>
 #include <stdio.h>
 #include <math.h>
+#include <float.h>
 
 #include "Box.h"
 #include "Plane.h"
 #include "Circle.h"
+#include "DebugDraw.h"
 
-void Box::CollideWithPlane(Plane* plane)
+void Box::CollideWithPlane(Plane* plane, std::vector<ContactManifold>& contacts)
 {
-	if (fixed)
+	if (IsFixed())
 		return;
 
-	int numContacts = 0;
-	glm::vec2 contact(0, 0);
-	float contactV = 0;
-	float radius = 0.5f * std::fminf(width, height);
+	glm::vec2 position = Position(), localX = LocalX(), localY = LocalY();
 
-	// which side is the centre of mass on?
+	// which side is the centre of mass on? Work from that side of the plane
 	float comFromPlane = glm::dot(position - plane->origin, plane->normal);
-	float penetration = 0;
+	if (comFromPlane == 0)
+		return;
+	glm::vec2 normal = comFromPlane > 0 ? plane->normal : -plane->normal;
+
+	ContactManifold manifold;
+	manifold.numPoints = 0;
 
 	// check all four corners to see if we've hit the plane
+	int corner = 0;
 	for (float x = -width / 2; x < width; x += width)
 	{
-		for (float y = -height / 2; y < height; y += height)
+		for (float y = -height / 2; y < height; y += height, corner++)
 		{
 			// get the position of the corner in world space
 			glm::vec2 p = position + x*localX + y*localY;
-			float distFromPlane = glm::dot(p - plane->origin, plane->normal);
-
-			// this is the velocity of the point, taken from linear velocity and angular velocity
-			float velocityIntoPlane = glm::dot(velocity + rotation*(-y*localX+ x*localY), plane->normal);
+			float distFromPlane = glm::dot(p - plane->origin, normal);
 
-			// if this corner is on the opposite side from the COM, and moving further in, we need to resolve the collision
-			if ((distFromPlane >= 0 && comFromPlane < 0 && velocityIntoPlane >= 0) 
-				|| (distFromPlane <= 0 && comFromPlane > 0 && velocityIntoPlane <= 0))
+			// if this corner is on the opposite side from the COM, it's touching
+			if (distFromPlane <= 0)
 			{
-				numContacts++;
-				contact += p;
-				contactV += velocityIntoPlane;
-				if (comFromPlane >= 0)
-				{
-					if (penetration > distFromPlane)
-						penetration = distFromPlane;
-				}
-				else
-				{
-					if (penetration < distFromPlane)
-						penetration = distFromPlane;
-				}
+				ContactPoint& point = manifold.points[manifold.numPoints++];
+				point.position = p;
+				point.separation = distFromPlane;
+				point.id = corner;
 			}
 		}
 	}
 
-	// we've had a hit - typically only two corners can contact
-	if (numContacts > 0)
+	if (manifold.numPoints > 0)
 	{
-		// get the average collision velocity into the plane (covers linear and rotational velcoity of all corners involved)
-		float collisionV = contactV / (float)numContacts;
-
-		// get the acceleration required to stop (restitution = 0) or reverse (restitution = 1) the average velocity into the plane
-		glm::vec2 acceleration = -plane->normal * ((1.0f + restitution) * collisionV);
-		// and the average position at which we'll apply the force (corner or edge centre)
-		glm::vec2 localContact = (contact / (float)numContacts);
-		// this is the perpendicular distance we apply the force at relative to the COM, so Torque = F*r
-		float r = glm::dot(localContact - position, glm::vec2(plane->normal.y, -plane->normal.x));
-		// work out the "effective mass" - this is a combination of moment of inertia and mass, and tells us how much the contact point velocity 
-		// will change with the force we're applying
-		float mass0 = 1.0f / (1.0f / mass + (r*r) / moment);
-
-		// and apply the force
-		ApplyForce(acceleration*mass0, localContact);
-		position -= plane->normal* penetration;
-		hasContact = true;
+		manifold.type = ContactManifold::BOX_PLANE;
+		manifold.a = this;
+		manifold.b = nullptr;
+		manifold.plane = plane;
+		manifold.normal = normal;
+		contacts.push_back(manifold);
 	}
 }
 
-void Box::CollideWithCircle(Circle* circle)
+void Box::CollideWithCircle(Circle* circle, std::vector<ContactManifold>& contacts)
 {
-	glm::vec2 circlePos = circle->position - position;
+	glm::vec2 position = Position(), localX = LocalX(), localY = LocalY();
+	glm::vec2 circlePos = circle->Position() - position;
 	float w2 = width / 2, h2 = height / 2;
 
 	int numContacts = 0;
 	// contact is in our box coordinates
 	glm::vec2 contact(0, 0);
-
+	// a bit for each corner and edge that's touching, which makes the feature id
+	unsigned int features = 0;
 
 	// check the four corners to see if any of them are inside the circle
+	int corner = 0;
 	for (float x = -w2; x < width; x += width)
 	{
-		for (float y = -h2; y < height; y += height)
+		for (float y = -h2; y < height; y += height, corner++)
 		{
 			glm::vec2 p = x*localX + y*localY;
 			glm::vec2 dp = p - circlePos;
@@ -99,13 +80,15 @@ void Box::CollideWithCircle(Circle* circle)
 			{
 				numContacts++;
 				contact += glm::vec2(x,y);
+				features |= 1 << corner;
 			}
 		}
 	}
 
 	// check the four edges for contact points. We transform the circle into the box's coordinate space and compare 
 	// its position to the edges in both the x and y direction
-	glm::vec2* direction = NULL;
+	glm::vec2 direction;
+	bool hasDirection = false;
 
 	// get the local position of the circle centre
 	glm::vec2 localPos(glm::dot(localX, circlePos), glm::dot(localY, circlePos));
@@ -115,13 +98,17 @@ void Box::CollideWithCircle(Circle* circle)
 		{
 			numContacts++;
 			contact += glm::vec2(w2, localPos.y);
-			direction = new glm::vec2(localX);
+			direction = localX;
+			hasDirection = true;
+			features |= 1 << 4;
 		}
 		if (localPos.x < 0 && localPos.x > -(w2 + circle->radius))
 		{
 			numContacts++;
 			contact += glm::vec2(-w2, localPos.y);
-			direction = new glm::vec2(-localX);
+			direction = -localX;
+			hasDirection = true;
+			features |= 1 << 5;
 		}
 	}
 	if (localPos.x < w2 && localPos.x > -w2)
@@ -130,13 +117,17 @@ void Box::CollideWithCircle(Circle* circle)
 		{
 			numContacts++;
 			contact += glm::vec2(localPos.x, h2);
-			direction = new glm::vec2(localY);
+			direction = localY;
+			hasDirection = true;
+			features |= 1 << 6;
 		}
 		if (localPos.y < 0 && localPos.y > -(h2 + circle->radius))
 		{
 			numContacts++;
 			contact += glm::vec2(localPos.x, -h2);
-			direction = new glm::vec2(-localY);
+			direction = -localY;
+			hasDirection = true;
+			features |= 1 << 7;
 		}
 	}
 	
@@ -144,31 +135,126 @@ void Box::CollideWithCircle(Circle* circle)
 	{
 		// average, and convert back into world coords
 		contact = position + (1.0f / numContacts) * (localX*contact.x + localY*contact.y);
-		ResolveCollision(circle, contact, direction);
+		// if it was only corners, push along the line between the centres
+		if (!hasDirection)
+			direction = glm::normalize(circlePos);
+
+		// how far apart the surfaces are, from the closest point on the box to the circle centre
+		glm::vec2 closest = glm::clamp(localPos, glm::vec2(-w2, -h2), glm::vec2(w2, h2));
+		float separation = glm::length(localPos - closest) - circle->radius;
+		AddContact(contacts, circle, contact, direction, separation, features);
 	}
-
-	delete direction;
 }
 
-void Box::CollideWithBox(Box* box)
+void Box::CollideWithBox(Box* box, std::vector<ContactManifold>& contacts)
 {
 	// separating axis theorem
 	// for each box, check the extents of the other box, looking for the smallest overlap
-	float overlap = FLT_MAX;
-	glm::vec2 normal;
-	glm::vec2 contact;
+	float overlap = FLT_MAX, otherOverlap = FLT_MAX;
+	glm::vec2 normal, otherNormal;
+	glm::vec2 contact, otherContact;
+	int edge = -1, otherEdge = -1;
 
 	// check both ways
-	if (CheckOverlap(box, overlap, contact, normal) && box->CheckOverlap(this, overlap, contact, normal))
+	if (!CheckOverlap(box, overlap, contact, normal, edge))
+		return;
+	if (!box->CheckOverlap(this, otherOverlap, otherContact, otherNormal, otherEdge))
+		return;
+
+	// the box whose edge gave the smallest overlap is the reference, and the other box's nearest edge gets clipped against it.
+	// Stick with ours unless theirs is clearly better, otherwise resting boxes flip between the two and lose their feature ids.
+	bool flipped = otherOverlap < 0.98f * overlap - 0.001f;
+	if (flipped)
+	{
+		normal = otherNormal;
+		edge = otherEdge;
+	}
+
+	// normal points out of the reference edge
+	Box* reference = flipped ? box : this;
+	Box* incident = flipped ? this : box;
+	float halfExtent = edge < 2 ? reference->width / 2 : reference->height / 2;
+	float sideExtent = edge < 2 ? reference->height / 2 : reference->width / 2;
+	glm::vec2 edgeCentre = reference->Position() + normal * halfExtent;
+	float edgeOffset = glm::dot(edgeCentre, normal);
+
+	// the incident edge is the one facing most directly back at the reference edge
+	glm::vec2 position = incident->Position(), localX = incident->LocalX(), localY = incident->LocalY();
+	float w2 = incident->width / 2, h2 = incident->height / 2;
+	float facing[4] = { -glm::dot(localX, normal), glm::dot(localX, normal), -glm::dot(localY, normal), glm::dot(localY, normal) };
+	int incidentEdge = 0;
+	for (int i = 1; i < 4; i++)
+	{
+		if (facing[i] < facing[incidentEdge])
+			incidentEdge = i;
+	}
+
+	// its two corners, numbered the same way as everywhere else: x major, -ve before +ve
+	static const int edgeCorners[4][2] = { { 0, 1 }, { 2, 3 }, { 0, 2 }, { 1, 3 } };
+	glm::vec2 points[2];
+	unsigned int features[2];
+	for (int i = 0; i < 2; i++)
+	{
+		int corner = edgeCorners[incidentEdge][i];
+		points[i] = position + ((corner & 2) ? w2 : -w2) * localX + ((corner & 1) ? h2 : -h2) * localY;
+		features[i] = corner;
+	}
+
+	// clip the incident edge to the sides of the reference edge. A clipped end is identified by the side that cut it
+	glm::vec2 tangent(-normal.y, normal.x);
+	float centre = glm::dot(edgeCentre, tangent);
+	for (int side = 0; side < 2; side++)
+	{
+		glm::vec2 sideNormal = side == 0 ? tangent : -tangent;
+		float sideOffset = (side == 0 ? centre : -centre) + sideExtent;
+		float d0 = glm::dot(points[0], sideNormal) - sideOffset;
+		float d1 = glm::dot(points[1], sideNormal) - sideOffset;
+		if (d0 > 0 && d1 > 0)
+			return;
+
+		unsigned int clipFeature = 4 + incidentEdge * 2 + side;
+		if (d0 > 0)
+		{
+			points[0] += (d0 / (d0 - d1)) * (points[1] - points[0]);
+			features[0] = clipFeature;
+		}
+		else if (d1 > 0)
+		{
+			points[1] += (d1 / (d1 - d0)) * (points[0] - points[1]);
+			features[1] = clipFeature;
+		}
+	}
+
+	// whatever's left behind the reference edge is touching
+	ContactManifold manifold;
+	manifold.numPoints = 0;
+	for (int i = 0; i < 2; i++)
 	{
-		ResolveCollision(box, contact, &normal);
+		float separation = glm::dot(points[i], normal) - edgeOffset;
+		if (separation > 0)
+			continue;
+
+		ContactPoint& point = manifold.points[manifold.numPoints++];
+		point.position = points[i];
+		point.separation = separation;
+		point.id = (flipped ? 128 : 0) | (edge << 4) | features[i];
 	}
 
+	if (manifold.numPoints == 0)
+		return;
+
+	manifold.type = ContactManifold::BODY_BODY;
+	manifold.a = this;
+	manifold.b = box;
+	manifold.plane = nullptr;
+	manifold.normal = flipped ? -normal : normal;
+	contacts.push_back(manifold);
 }
 
-// returns true if there is overlap
-bool Box::CheckOverlap(Box* box, float& overlap, glm::vec2& contact, glm::vec2& normal)
+// returns true if there is overlap. edge is which of our edges the smallest overlap was through: -x, +x, -y, +y
+bool Box::CheckOverlap(Box* box, float& overlap, glm::vec2& contact, glm::vec2& normal, int& edge)
 {
+	glm::vec2 position = Position(), localX = LocalX(), localY = LocalY();
 	// our extents in our space are (-w2, w2) in x and (-h2, h2) in y
 	float w2 = width / 2, h2 = height / 2;
 
@@ -181,7 +267,7 @@ bool Box::CheckOverlap(Box* box, float& overlap, glm::vec2& contact, glm::vec2&
 	{
 		for (float y = -box->height / 2; y < box->height; y += box->height)
 		{
-			glm::vec2 p = box->position + x*box->localX + y*box->localY; // position in worldspace
+			glm::vec2 p = box->Position() + x*box->LocalX() + y*box->LocalY(); // position in worldspace
 			glm::vec2 p0(glm::dot(p - position, localX), glm::dot(p - position, localY)); // position in our box's space
 
 			if (first || p0.x < xmin) {	xmin = p0.x; xminPos = p; }
@@ -205,6 +291,7 @@ bool Box::CheckOverlap(Box* box, float& overlap, glm::vec2& contact, glm::vec2&
 			contact = xmaxPos;
 			overlap = overlap0;
 			normal = -localX;
+			edge = 0;
 		}
 	}
 
@@ -218,6 +305,7 @@ bool Box::CheckOverlap(Box* box, float& overlap, glm::vec2& contact, glm::vec2&
 			contact = xminPos;
 			overlap = overlap1;
 			normal = localX;
+			edge = 1;
 		}
 	}
 
@@ -231,6 +319,7 @@ bool Box::CheckOverlap(Box* box, float& overlap, glm::vec2& contact, glm::vec2&
 			contact = ymaxPos;
 			overlap = overlap2;
 			normal = -localY;
+			edge = 2;
 		}
 	}
 
@@ -244,6 +333,7 @@ bool Box::CheckOverlap(Box* box, float& overlap, glm::vec2& contact, glm::vec2&
 			contact = yminPos;
 			overlap = overlap3;
 			normal = localY;
+			edge = 3;
 		}
 	}
 
@@ -252,7 +342,7 @@ bool Box::CheckOverlap(Box* box, float& overlap, glm::vec2& contact, glm::vec2&
 
 
 /*
-void Box::CollideWithBox(Box* box)
+void Box::CollideWithBox(Box* box, std::vector<ContactManifold>& contacts)
 {
 	glm::vec2 boxPos = box->position - position;
 	
@@ -309,14 +399,15 @@ void Box::CollideWithBox(Box* box)
 // check if any of the other boxes corners are inside us
 void Box::CheckBoxCorners(Box* box, glm::vec2& contact, int& numContacts, glm::vec2& edgeNormal)
 {
+	glm::vec2 position = Position(), localX = LocalX(), localY = LocalY();
 	// get the centre of mass of the other box in our space
-	glm::vec2 com(glm::dot(box->position - position, localX), glm::dot(box->position - position, localY));
+	glm::vec2 com(glm::dot(box->Position() - position, localX), glm::dot(box->Position() - position, localY));
 
 	for (float x = -box->width / 2; x < box->width; x += box->width)
 	{
 		for (float y = -box->height / 2; y < box->height; y += box->height)
 		{
-			glm::vec2 p = box->position + x*box->localX + y*box->localY; // position in worldspace
+			glm::vec2 p = box->Position() + x*box->LocalX() + y*box->LocalY(); // position in worldspace
 			glm::vec2 p0(glm::dot(p - position, localX), glm::dot(p - position, localY)); // position in our box's space
 
 			float w2 = width / 2, h2 = height / 2;
@@ -366,6 +457,7 @@ void Box::CheckBoxCorners(Box* box, glm::vec2& contact, int& numContacts, glm::v
 // check if any of the other boxes corners are inside us
 bool Box::CheckBoxCorners2(Box* box, glm::vec2& contact, int& numContacts, float &pen, glm::vec2& edgeNormal)
 {
+	glm::vec2 position = Position(), localX = LocalX(), localY = LocalY();
 	float minX, maxX, minY, maxY;
 	float w2 = width / 2, h2 = height / 2;
 	int numLocalContacts = 0;
@@ -376,7 +468,7 @@ bool Box::CheckBoxCorners2(Box* box, glm::vec2& contact, int& numContacts, float
 	{
 		for (float y = -box->height / 2; y < box->height; y += box->height)
 		{
-			glm::vec2 p = box->position + x*box->localX + y*box->localY; // position in worldspace
+			glm::vec2 p = box->Position() + x*box->LocalX() + y*box->LocalY(); // position in worldspace
 			glm::vec2 p0(glm::dot(p - position, localX), glm::dot(p - position, localY)); // position in our box's space
 
 			if (first || p0.x < minX) minX = p0.x;
@@ -434,21 +526,43 @@ bool Box::CheckBoxCorners2(Box* box, glm::vec2& contact, int& numContacts, float
 	return res;
 }
 
-void Box::Draw()
+void Box::Draw(DebugDraw* draw)
 {
+	glm::vec2 position = DrawPosition();
+	float angle = DrawAngle();
+	glm::vec2 localX(cosf(angle), sinf(angle)), localY(-localX.y, localX.x);
 	glm::vec2 p1 = position - localX * width / 2.0f - localY * height / 2.0f;
 	glm::vec2 p2 = position + localX * width / 2.0f - localY * height / 2.0f;
 	glm::vec2 p3 = position - localX * width / 2.0f + localY * height / 2.0f;
 	glm::vec2 p4 = position + localX * width / 2.0f + localY * height / 2.0f;
+	bool awake = IsAwake() || IsFixed();
 	glm::vec4 col = awake ? color : glm::vec4(0,1,1,1);
 	glm::vec4 col2 = awake ? glm::vec4(1, 1, 0, 1) : glm::vec4(0, 1, 1, 1);
-	Gizmos::add2DTri(p1, p2, p4, col);
-	Gizmos::add2DTri(p1, p4, p3, col2);
+	draw->add2DTri(p1, p2, p4, col);
+	draw->add2DTri(p1, p4, p3, col2);
 }
 
 bool Box::IsInside(glm::vec2 pt)
 {
-	pt -= position;
-	glm::vec2 boxPt(glm::dot(pt, localX), glm::dot(pt, localY));
+	pt -= Position();
+	glm::vec2 boxPt(glm::dot(pt, LocalX()), glm::dot(pt, LocalY()));
 	return (fabs(boxPt.x) < width*0.5f && fabs(boxPt.y) < height*0.5f);
+}
+
+AABB Box::GetAABB()
+{
+	// project the rotated half extents onto the world axes
+	glm::vec2 extents = glm::abs(LocalX()) * (width * 0.5f) + glm::abs(LocalY()) * (height * 0.5f);
+	return { Position() - extents, Position() + extents };
+}
+
+bool Box::RayCast(glm::vec2 start, glm::vec2 end, float& fraction)
+{
+	// in our space we're just an axis aligned box
+	glm::vec2 position = Position(), localX = LocalX(), localY = LocalY();
+	glm::vec2 s = start - position, e = end - position;
+	glm::vec2 localStart(glm::dot(s, localX), glm::dot(s, localY));
+	glm::vec2 localEnd(glm::dot(e, localX), glm::dot(e, localY));
+	glm::vec2 extents(width * 0.5f, height * 0.5f);
+	return Broadphase::RayHitsAABB({ -extents, extents }, localStart, localEnd, 1, fraction);
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include <glm/glm/glm.hpp>
+#include <algorithm>
+#include <math.h>
+
+#include "Broadphase.h"
+#include "SpatialHash.h"
+#include "SweepAndPrune.h"
+#include "AABBTree.h"
+#include "RigidBody.h"
+
+Broadphase* Broadphase::Create(BroadphaseType type)
+{
+	switch (type)
+	{
+	case SPATIAL_HASH:
+		return new SpatialHash();
+	case SWEEP_AND_PRUNE:
+		return new SweepAndPrune();
+	case AABB_TREE:
+		return new AABBTree();
+	default:
+		return new BruteForceBroadphase();
+	}
+}
+
+bool Broadphase::CanCollide(RigidBody* a, RigidBody* b)
+{
+	return a->IsAwake() || b->IsAwake();
+}
+
+BroadphasePair Broadphase::MakePair(RigidBody* a, RigidBody* b)
+{
+	if (b->oType < a->oType)
+		return { b, a };
+	return { a, b };
+}
+
+bool Broadphase::RayHitsAABB(const AABB& aabb, glm::vec2 start, glm::vec2 end, float maxFraction, float& fraction)
+{
+	glm::vec2 d = end - start;
+	float tmin = 0, tmax = maxFraction;
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (fabsf(d[axis]) < 1e-8f)
+		{
+			// parallel to this slab, so must start inside it
+			if (start[axis] < aabb.min[axis] || start[axis] > aabb.max[axis])
+				return false;
+		}
+		else
+		{
+			float inv = 1.0f / d[axis];
+			float t1 = (aabb.min[axis] - start[axis]) * inv;
+			float t2 = (aabb.max[axis] - start[axis]) * inv;
+			if (t1 > t2)
+				std::swap(t1, t2);
+			tmin = fmaxf(tmin, t1);
+			tmax = fminf(tmax, t2);
+			if (tmin > tmax)
+				return false;
+		}
+	}
+	fraction = tmin;
+	return true;
+}
+
+void Broadphase::LinearQuery(const std::vector<RigidBody*>& bodies, const AABB& aabb, std::vector<RigidBody*>& results)
+{
+	for (auto body : bodies)
+	{
+		if (body->GetAABB().Overlaps(aabb))
+			results.push_back(body);
+	}
+}
+
+RigidBody* Broadphase::LinearRayCast(const std::vector<RigidBody*>& bodies, glm::vec2 start, glm::vec2 end, float& fraction)
+{
+	RigidBody* hit = nullptr;
+	fraction = 1;
+	for (auto body : bodies)
+	{
+		float t;
+		if (body->RayCast(start, end, t) && t < fraction)
+		{
+			fraction = t;
+			hit = body;
+		}
+	}
+	return hit;
+}
+
+void BruteForceBroadphase::AddBody(RigidBody* body)
+{
+	body->proxy = (int)m_bodies.size();
+	m_bodies.push_back(body);
+}
+
+void BruteForceBroadphase::RemoveBody(RigidBody* body)
+{
+	// swap the last body into the hole
+	int index = body->proxy;
+	m_bodies[index] = m_bodies.back();
+	m_bodies[index]->proxy = index;
+	m_bodies.pop_back();
+	body->proxy = -1;
+}
+
+void BruteForceBroadphase::FindPairs(std::vector<BroadphasePair>& pairs)
+{
+	int count = (int)m_bodies.size();
+	m_aabbs.resize(count);
+	for (int i = 0; i < count; i++)
+		m_aabbs[i] = m_bodies[i]->GetAABB();
+
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = i + 1; j < count; j++)
+		{
+			if (m_aabbs[i].Overlaps(m_aabbs[j]) && CanCollide(m_bodies[i], m_bodies[j]))
+				pairs.push_back(MakePair(m_bodies[i], m_bodies[j]));
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+#include <vector>
+
+class RigidBody;
+class JobSystem;
+
+// axis aligned bounding box in world space
+struct AABB
+{
+	glm::vec2 min;
+	glm::vec2 max;
+
+	bool Overlaps(const AABB& other) const
+	{
+		return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y;
+	}
+};
+
+// a pair of bodies whose bounding boxes overlap, and so need the full collision test
+struct BroadphasePair
+{
+	RigidBody* a;
+	RigidBody* b;
+};
+
+// finds the candidate pairs of rigid bodies that might be colliding.
+// Planes and springs never go in here, the world tests planes against every body itself.
+class Broadphase
+{
+public:
+	enum BroadphaseType
+	{
+		BRUTE_FORCE,
+		SPATIAL_HASH,
+		SWEEP_AND_PRUNE,
+		AABB_TREE,
+	};
+
+	static Broadphase* Create(BroadphaseType type);
+
+	virtual ~Broadphase() {}
+
+	virtual BroadphaseType GetType() = 0;
+
+	virtual void AddBody(RigidBody* body) = 0;
+	virtual void RemoveBody(RigidBody* body) = 0;
+
+	// called once per step after the bodies have moved
+	virtual void FindPairs(std::vector<BroadphasePair>& pairs) = 0;
+
+	// finds every body whose bounds overlap the box. Bounds are as of the last FindPairs()
+	virtual void Query(const AABB& aabb, std::vector<RigidBody*>& results) = 0;
+
+	// finds the first body hit along the line from start to end. fraction is how far along the line the hit is
+	virtual RigidBody* RayCast(glm::vec2 start, glm::vec2 end, float& fraction) = 0;
+
+	// pairs where neither body is awake can't have changed since last step, so they're never reported.
+	// That includes pairs of fixed bodies, which are never awake
+	static bool CanCollide(RigidBody* a, RigidBody* b);
+
+	// puts the body with the lower shape type first, which is the order Collision's table expects
+	static BroadphasePair MakePair(RigidBody* a, RigidBody* b);
+
+	// slab test of the line from start to end against a box, only counting hits closer than maxFraction
+	static bool RayHitsAABB(const AABB& aabb, glm::vec2 start, glm::vec2 end, float maxFraction, float& fraction);
+
+	// set by the world. Broadphases that can split FindPairs() across threads use it, the rest ignore it
+	JobSystem* jobs = nullptr;
+
+protected:
+	// brute force versions of the queries for broadphases that don't have anything better
+	static void LinearQuery(const std::vector<RigidBody*>& bodies, const AABB& aabb, std::vector<RigidBody*>& results);
+	static RigidBody* LinearRayCast(const std::vector<RigidBody*>& bodies, glm::vec2 start, glm::vec2 end, float& fraction);
+};
+
+// tests every body against every other body. Only here as a reference to benchmark the others against.
+class BruteForceBroadphase : public Broadphase
+{
+public:
+	virtual BroadphaseType GetType() { return BRUTE_FORCE; }
+
+	virtual void AddBody(RigidBody* body);
+	virtual void RemoveBody(RigidBody* body);
+	virtual void FindPairs(std::vector<BroadphasePair>& pairs);
+
+	virtual void Query(const AABB& aabb, std::vector<RigidBody*>& results) { LinearQuery(m_bodies, aabb, results); }
+	virtual RigidBody* RayCast(glm::vec2 start, glm::vec2 end, float& fraction) { return LinearRayCast(m_bodies, start, end, fraction); }
+
+	std::vector<RigidBody*> m_bodies;
+	std::vector<AABB> m_aabbs;
+};
\ No newline at end of file
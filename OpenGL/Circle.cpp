@@ -1,43 +1,60 @@
-#include <gl_core_4_4.h>
-#include <glm\glm\glm.hpp>
-#include <aie/Gizmos.h>
+#include <glm/glm/glm.hpp>
+#include <math.h>
 
 #include "Circle.h"
 #include "Plane.h"
 #include "Box.h"
+#include "DebugDraw.h"
 
-void Circle::CollideWithPlane(Plane* plane)
+// bullets are stopped this far into whatever they hit, so the narrowphase picks up the contact and bounces them off it
+static const float BULLET_PENETRATION = 0.01f;
+static const int MAX_ADVANCEMENT_STEPS = 20;
+
+void Circle::CollideWithPlane(Plane* plane, std::vector<ContactManifold>& contacts)
 {
+	if (IsFixed())
+		return;
+
+	glm::vec2 position = Position();
 	float distFromPlane = (position.x - plane->origin.x)* plane->normal.x + (position.y - plane->origin.y)* plane->normal.y;
-	float velocityIntoPlane = velocity.x * plane->normal.x + velocity.y * plane->normal.y;
+	glm::vec2 normal = plane->normal;
 
 	// one sided plane is infinitely thick behind the normal, and thus ejects anything inside it no matter how far in
 	if (plane->oneSided)
 	{
-		if (distFromPlane < radius && velocityIntoPlane < 0)
-		{
-			ApplyForce(-mass*(plane->normal * (1.0f + restitution) * velocityIntoPlane), position);
-			ApplyContactForce(radius - distFromPlane, plane->normal);
-		}
+		if (distFromPlane >= radius)
+			return;
 	}
 	else // two sided plane - which side you're on is determined by where the centre is. Easier to set up but can lead to tunnelling at high speeds.
 	{
-		if (distFromPlane > 0 && distFromPlane < radius && velocityIntoPlane < 0)
-		{
-			ApplyForce(-mass*(plane->normal * (1.0f + restitution) * velocityIntoPlane), position);
-		}
+		if (distFromPlane == 0 || distFromPlane >= radius || distFromPlane <= -radius)
+			return;
 
-		if (distFromPlane < 0 && distFromPlane > -radius && velocityIntoPlane > 0)
+		// behind the plane, so work from that side
+		if (distFromPlane < 0)
 		{
-			ApplyForce(-mass*(plane->normal *  (1.0f + restitution) * velocityIntoPlane), position);
+			normal = -normal;
+			distFromPlane = -distFromPlane;
 		}
 	}
+
+	ContactManifold manifold;
+	manifold.type = ContactManifold::CIRCLE_PLANE;
+	manifold.a = this;
+	manifold.b = nullptr;
+	manifold.plane = plane;
+	manifold.normal = normal;
+	manifold.numPoints = 1;
+	manifold.points[0].position = position - normal * radius;
+	manifold.points[0].separation = distFromPlane - radius;
+	contacts.push_back(manifold);
 }
 
-void Circle::CollideWithCircle(Circle* circle)
+void Circle::CollideWithCircle(Circle* circle, std::vector<ContactManifold>& contacts)
 {
 	// find the vector between their centres
-	glm::vec2 disp = circle->position - position;
+	glm::vec2 position = Position();
+	glm::vec2 disp = circle->Position() - position;
 	// and get its length, so we can normalise later
 	float d = sqrtf(disp.x*disp.x + disp.y*disp.y);
 
@@ -45,23 +62,105 @@ void Circle::CollideWithCircle(Circle* circle)
 	// note that the position we pass in here is incorrect (its the midpoint bewteen the radii rather than the actual contact point)
 	// but anywhere on the line between the radii will be OK because no torque will be applied.
 	if (d > 0 && d < (radius + circle->radius))
-		ResolveCollision(circle, 0.5f*(position+circle->position));
+		AddContact(contacts, circle, 0.5f*(position+circle->Position()), disp / d, d - (radius + circle->radius), 0);
 }
 
-void Circle::CollideWithBox(Box* box)
+float Circle::TimeOfImpact(Plane* plane, glm::vec2 start, glm::vec2 end)
 {
-	box->CollideWithCircle(this);
+	float d0 = glm::dot(start - plane->origin, plane->normal);
+	float d1 = glm::dot(end - plane->origin, plane->normal);
+
+	// a two sided plane is hit from whichever side the move starts on
+	if (!plane->oneSided && d0 < 0)
+	{
+		d0 = -d0;
+		d1 = -d1;
+	}
+
+	// already touching at the start is left to the narrowphase
+	float contactDist = radius - BULLET_PENETRATION;
+	if (d0 <= contactDist || d1 >= contactDist)
+		return 1;
+	return (d0 - contactDist) / (d0 - d1);
 }
 
-void Circle::Draw()
+// conservative advancement. The distance to the box tells us how far we can safely move before we could possibly
+// touch it, given how fast the two are closing and how fast the box's corners are swinging round. Keep stepping
+// on by that much until we're there, or past the end of the move.
+float Circle::TimeOfImpact(Box* box, glm::vec2 start, glm::vec2 end, float dt)
 {
-	Gizmos::add2DCircle(position, radius, 32, color);
+	// the box's move over the step, run backwards from where it is now
+	glm::vec2 boxEnd = box->Position(), boxMove = box->Velocity() * dt;
+	float angleEnd = box->Angle(), turn = box->Rotation() * dt;
+	glm::vec2 extents(box->width * 0.5f, box->height * 0.5f);
+
+	float closingBound = glm::length((end - start) - boxMove) + fabsf(turn) * glm::length(extents);
+	if (closingBound <= 0)
+		return 1;
+
+	float t = 0;
+	for (int i = 0; i < MAX_ADVANCEMENT_STEPS; i++)
+	{
+		glm::vec2 boxPos = boxEnd - boxMove * (1 - t);
+		float angle = angleEnd - turn * (1 - t);
+		float cs = cosf(angle), sn = sinf(angle);
+		glm::vec2 d = start + (end - start) * t - boxPos;
+		glm::vec2 local(d.x * cs + d.y * sn, -d.x * sn + d.y * cs);
+		glm::vec2 closest = glm::clamp(local, -extents, extents);
+		float gap = glm::length(local - closest) - (radius - BULLET_PENETRATION);
+
+		// already touching at the start is left to the narrowphase
+		if (i == 0 && gap <= BULLET_PENETRATION)
+			return 1;
+		if (gap < 0.5f * BULLET_PENETRATION)
+			return t;
+
+		t += gap / closingBound;
+		if (t >= 1)
+			return 1;
+	}
+	return t;
+}
+
+void Circle::Draw(DebugDraw* draw)
+{
+	draw->add2DCircle(DrawPosition(), radius, 32, color);
 	// add a "highlight" marker so we can see rotation
-	Gizmos::add2DCircle(position + radius*0.5f*localX, radius*0.25f, 16, glm::vec4(1, 1, 1, 1));
+	draw->add2DCircle(DrawToWorld(glm::vec2(radius*0.5f, 0)), radius*0.25f, 16, glm::vec4(1, 1, 1, 1));
 }
 
 bool Circle::IsInside(glm::vec2 pt)
 {
-	pt -= position;
+	pt -= Position();
 	return ((pt.x*pt.x+pt.y*pt.y) < radius*radius);
+}
+
+AABB Circle::GetAABB()
+{
+	glm::vec2 extents(radius, radius);
+	return { Position() - extents, Position() + extents };
+}
+
+bool Circle::RayCast(glm::vec2 start, glm::vec2 end, float& fraction)
+{
+	// solve |start + t*d - position| = radius for t
+	glm::vec2 d = end - start;
+	glm::vec2 f = start - Position();
+	float a = glm::dot(d, d);
+	float b = 2 * glm::dot(f, d);
+	float c = glm::dot(f, f) - radius*radius;
+
+	// starting inside counts as an immediate hit
+	if (c <= 0)
+	{
+		fraction = 0;
+		return true;
+	}
+
+	float discriminant = b*b - 4 * a*c;
+	if (a == 0 || discriminant < 0)
+		return false;
+
+	fraction = (-b - sqrtf(discriminant)) / (2 * a);
+	return fraction >= 0 && fraction <= 1;
 }
\ No newline at end of file
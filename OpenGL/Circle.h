@@ -8,23 +8,29 @@ public:
 	Circle() { oType = CIRCLE; }
 	Circle(glm::vec2 p, glm::vec2 v, float r = 1, float a = 0, float density = 1) 
 	{
-		position = p;
-		velocity = v;
-		angle = a;
-		rotation = 0;
-		mass = 3.14159f * r * r * density;
+		def.position = p;
+		def.velocity = v;
+		def.angle = a;
+		def.rotation = 0;
+		def.mass = 3.14159f * r * r * density;
 		radius = r;
 		oType = CIRCLE; 
-		moment = 0.5f* mass * radius*radius;
-		awake = true;
-		fixed = false;
+		def.moment = 0.5f* def.mass * radius*radius;
+		def.awake = true;
+		def.fixed = false;
 	}
 
-	virtual void CollideWithPlane(Plane* plane);
-	virtual void CollideWithCircle(Circle* circle);
-	virtual void CollideWithBox(Box* box);
-	virtual void Draw();
+	// collision tests only read state, adding a manifold to contacts if they're touching. See Collision for box-circle
+	void CollideWithPlane(Plane* plane, std::vector<ContactManifold>& contacts);
+	void CollideWithCircle(Circle* circle, std::vector<ContactManifold>& contacts);
+	// continuous collision for bullets. How far along the move from start to end the circle first sinks into the plane
+	// or box, from 0 to 1, or 1 if it doesn't. The box is taken to have moved and turned at its current speed over dt.
+	float TimeOfImpact(Plane* plane, glm::vec2 start, glm::vec2 end);
+	float TimeOfImpact(Box* box, glm::vec2 start, glm::vec2 end, float dt);
+	virtual void Draw(DebugDraw* draw);
 	virtual bool IsInside(glm::vec2 pt);
+	virtual AABB GetAABB();
+	virtual bool RayCast(glm::vec2 start, glm::vec2 end, float& fraction);
 
 	float radius = 1;
 };
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include <glm/glm/glm.hpp>
+
+#include "Collision.h"
+#include "Plane.h"
+#include "Circle.h"
+#include "Box.h"
+
+// planes against planes, and anything below the diagonal
+static void CollideNothing(PhysicsObject*, PhysicsObject*, std::vector<ContactManifold>&)
+{
+}
+
+static void CollidePlaneCircle(PhysicsObject* a, PhysicsObject* b, std::vector<ContactManifold>& contacts)
+{
+	((Circle*)b)->CollideWithPlane((Plane*)a, contacts);
+}
+
+static void CollidePlaneBox(PhysicsObject* a, PhysicsObject* b, std::vector<ContactManifold>& contacts)
+{
+	((Box*)b)->CollideWithPlane((Plane*)a, contacts);
+}
+
+// for two of the same shape the second one does the test, so manifolds point the same way they always have
+static void CollideCircleCircle(PhysicsObject* a, PhysicsObject* b, std::vector<ContactManifold>& contacts)
+{
+	((Circle*)b)->CollideWithCircle((Circle*)a, contacts);
+}
+
+static void CollideCircleBox(PhysicsObject* a, PhysicsObject* b, std::vector<ContactManifold>& contacts)
+{
+	((Box*)b)->CollideWithCircle((Circle*)a, contacts);
+}
+
+static void CollideBoxBox(PhysicsObject* a, PhysicsObject* b, std::vector<ContactManifold>& contacts)
+{
+	((Box*)b)->CollideWithBox((Box*)a, contacts);
+}
+
+const Collision::CollideFunction Collision::s_table[NUM_SHAPES][NUM_SHAPES] =
+{
+	// PLANE            CIRCLE               BOX
+	{ CollideNothing, CollidePlaneCircle,  CollidePlaneBox },  // PLANE
+	{ CollideNothing, CollideCircleCircle, CollideCircleBox }, // CIRCLE
+	{ CollideNothing, CollideNothing,      CollideBoxBox },    // BOX
+};
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+
+#include "PhysicsObject.h"
+
+// the narrowphase's way in. Every pair of shape types has a free function in a table, looked up by the types of the
+// two objects, so testing a pair is one indirect call rather than a virtual call that turns round and makes another.
+// Only pairs with the lower type first are in the table, which is how the broadphase always reports them
+// (see Broadphase::MakePair), so pairs can be grouped by type and run through the same function.
+class Collision
+{
+public:
+	enum { NUM_SHAPES = PhysicsObject::BOX + 1 };
+
+	typedef void(*CollideFunction)(PhysicsObject* a, PhysicsObject* b, std::vector<ContactManifold>& contacts);
+
+	// typeA must be no higher than typeB
+	static CollideFunction Get(int typeA, int typeB) { return s_table[typeA][typeB]; }
+
+	// any two objects, in either order
+	static void Collide(PhysicsObject* a, PhysicsObject* b, std::vector<ContactManifold>& contacts)
+	{
+		if (b->oType < a->oType)
+			s_table[b->oType][a->oType](b, a, contacts);
+		else
+			s_table[a->oType][b->oType](a, b, contacts);
+	}
+
+private:
+	static const CollideFunction s_table[NUM_SHAPES][NUM_SHAPES];
+};
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+
+class RigidBody;
+class Plane;
+
+// a single point where two things touch
+struct ContactPoint
+{
+	glm::vec2 position;
+	// distance past the surface along the manifold normal, negative when penetrating
+	float separation;
+	// which features of the two shapes made this point, so it can be matched up with the same point next step
+	unsigned int id = 0;
+	// total impulse applied along the normal this step. Carried over from last step when the id matches.
+	float normalImpulse = 0;
+	// speed the points should be moving apart once solved, from restitution
+	float targetVelocity = 0;
+};
+
+// everything the narrowphase found out about one touching pair. Collision tests only read body state and
+// write these, and the solver applies them afterwards, so the tests can run on any number of threads.
+struct ContactManifold
+{
+	enum { MAX_POINTS = 4 };
+
+	// which response the solver applies
+	enum ManifoldType
+	{
+		BODY_BODY,
+		CIRCLE_PLANE,
+		BOX_PLANE,
+	};
+
+	ManifoldType type;
+	RigidBody* a;
+	// null for plane contacts
+	RigidBody* b;
+	Plane* plane;
+	// points from a towards b. For plane contacts it's the plane normal, flipped to the side a is on
+	glm::vec2 normal;
+	int numPoints;
+	ContactPoint points[MAX_POINTS];
+};
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include <glm/glm/glm.hpp>
+#include <math.h>
+
+#include "ContactSolver.h"
+#include "BodyStore.h"
+#include "RigidBody.h"
+#include "DebugDraw.h"
+
+// closing speed below which contacts don't bounce
+static const float RESTITUTION_THRESHOLD = 1.0f;
+// penetration that's allowed to remain, so resting contacts stay touching from one step to the next
+static const float LINEAR_SLOP = 0.005f;
+// fraction of the remaining penetration taken out each step
+static const float BAUMGARTE = 0.2f;
+
+static float Cross(glm::vec2 a, glm::vec2 b)
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+// velocity of point r on a body, given its linear and angular velocity
+static glm::vec2 PointVelocity(glm::vec2 v, float w, glm::vec2 r)
+{
+	return v + w * glm::vec2(-r.y, r.x);
+}
+
+void ContactSolver::SolveIsland(BodyStore& store, const int* bodies, int numBodies, int* bodySlot,
+	std::vector<ContactManifold>& manifolds, const int* contacts, int numContacts)
+{
+	m_velocity.resize(numBodies);
+	m_rotation.resize(numBodies);
+	m_pseudoVelocity.resize(numBodies);
+	m_pseudoRotation.resize(numBodies);
+	m_invMass.resize(numBodies);
+	m_invMoment.resize(numBodies);
+	for (int i = 0; i < numBodies; i++)
+	{
+		int index = bodies[i];
+		bodySlot[index] = i;
+		m_velocity[i] = store.velocity[index];
+		m_rotation[i] = store.rotation[index];
+		m_pseudoVelocity[i] = glm::vec2(0, 0);
+		m_pseudoRotation[i] = 0;
+		m_invMass[i] = store.invMass[index];
+		m_invMoment[i] = store.invMoment[index];
+	}
+
+	Prepare(store, bodySlot, manifolds, contacts, numContacts);
+	if (m_constraints.empty())
+		return;
+
+	WarmStart();
+	for (int i = 0; i < velocityIterations; i++)
+		SolveVelocities();
+	for (int i = 0; i < positionIterations; i++)
+		SolvePositions();
+
+	// copy the results back, moving the bodies out of each other with the pseudo velocities
+	for (int i = 0; i < numBodies; i++)
+	{
+		int index = bodies[i];
+		store.velocity[index] = m_velocity[i];
+		store.rotation[index] = m_rotation[i];
+		store.position[index] += m_pseudoVelocity[i] * dt;
+		store.angle[index] += m_pseudoRotation[i] * dt;
+	}
+
+	for (auto& c : m_constraints)
+		c.point->normalImpulse = c.normalImpulse;
+}
+
+// turns each point of each manifold into a constraint. Planes and fixed bodies become slot -1, which the solver
+// treats as immovable, so nothing shared between islands is ever written to. Everything else is awake.
+void ContactSolver::Prepare(BodyStore& store, const int* bodySlot, std::vector<ContactManifold>& manifolds, const int* contacts, int numContacts)
+{
+	m_constraints.clear();
+	for (int i = 0; i < numContacts; i++)
+	{
+		ContactManifold& manifold = manifolds[contacts[i]];
+
+		// for plane contacts the plane is a, so the normal still points from a to b
+		int indexA = manifold.b ? manifold.a->Index() : -1;
+		int indexB = manifold.b ? manifold.b->Index() : manifold.a->Index();
+		bool fixedA = indexA < 0 || !(store.flags[indexA] & BodyStore::AWAKE);
+		bool fixedB = !(store.flags[indexB] & BodyStore::AWAKE);
+
+		numSolved++;
+
+		int a = fixedA ? -1 : bodySlot[indexA];
+		int b = fixedB ? -1 : bodySlot[indexB];
+		glm::vec2 positionA = indexA >= 0 ? store.position[indexA] : glm::vec2(0, 0);
+		glm::vec2 positionB = store.position[indexB];
+		float invMassA = a >= 0 ? m_invMass[a] : 0, invMomentA = a >= 0 ? m_invMoment[a] : 0;
+		float invMassB = b >= 0 ? m_invMass[b] : 0, invMomentB = b >= 0 ? m_invMoment[b] : 0;
+		glm::vec2 velocityA = a >= 0 ? m_velocity[a] : glm::vec2(0, 0);
+		glm::vec2 velocityB = b >= 0 ? m_velocity[b] : glm::vec2(0, 0);
+		float rotationA = a >= 0 ? m_rotation[a] : 0;
+		float rotationB = b >= 0 ? m_rotation[b] : 0;
+		float restitution = store.restitution[manifold.a->Index()];
+
+		for (int j = 0; j < manifold.numPoints; j++)
+		{
+			ContactPoint& point = manifold.points[j];
+
+			ContactConstraint c;
+			c.a = a;
+			c.b = b;
+			c.normal = manifold.normal;
+			c.rA = point.position - positionA;
+			c.rB = point.position - positionB;
+
+			float rnA = Cross(c.rA, c.normal), rnB = Cross(c.rB, c.normal);
+			float k = invMassA + invMassB + invMomentA * rnA * rnA + invMomentB * rnB * rnB;
+			c.normalMass = k > 0 ? 1.0f / k : 0.0f;
+
+			// slow contacts don't bounce, otherwise things resting on each other never settle
+			float closing = glm::dot(PointVelocity(velocityB, rotationB, c.rB) - PointVelocity(velocityA, rotationA, c.rA), c.normal);
+			c.targetVelocity = closing < -RESTITUTION_THRESHOLD ? -restitution * closing : 0.0f;
+			c.bias = BAUMGARTE * fmaxf(-point.separation - LINEAR_SLOP, 0.0f) / dt;
+
+			c.normalImpulse = point.normalImpulse;
+			c.positionImpulse = 0;
+			c.point = &point;
+			m_constraints.push_back(c);
+
+			if (debugDraw)
+			{
+				debugDraw->add2DCircle(point.position, 1.0f, 12, glm::vec4(1, 1, 1, 1));
+				if (point.normalImpulse > 0)
+					debugDraw->add2DCircle(point.position, 0.9f, 12, glm::vec4(0, 0, 0, 1));
+			}
+		}
+	}
+}
+
+// applies last step's impulses, so a resting stack starts off already holding itself up
+void ContactSolver::WarmStart()
+{
+	for (auto& c : m_constraints)
+	{
+		glm::vec2 impulse = c.normalImpulse * c.normal;
+		if (c.a >= 0)
+		{
+			m_velocity[c.a] -= m_invMass[c.a] * impulse;
+			m_rotation[c.a] -= m_invMoment[c.a] * Cross(c.rA, impulse);
+		}
+		if (c.b >= 0)
+		{
+			m_velocity[c.b] += m_invMass[c.b] * impulse;
+			m_rotation[c.b] += m_invMoment[c.b] * Cross(c.rB, impulse);
+		}
+	}
+}
+
+// one pass over every point, changing its impulse so the points move apart at the target speed. The total over the
+// step is clamped rather than this bit of it, so earlier pushes can be taken back but it never pulls.
+void ContactSolver::SolveVelocities()
+{
+	for (auto& c : m_constraints)
+	{
+		glm::vec2 velocityA = c.a >= 0 ? PointVelocity(m_velocity[c.a], m_rotation[c.a], c.rA) : glm::vec2(0, 0);
+		glm::vec2 velocityB = c.b >= 0 ? PointVelocity(m_velocity[c.b], m_rotation[c.b], c.rB) : glm::vec2(0, 0);
+		float closing = glm::dot(velocityB - velocityA, c.normal);
+
+		float total = fmaxf(c.normalImpulse + c.normalMass * (c.targetVelocity - closing), 0.0f);
+		glm::vec2 impulse = (total - c.normalImpulse) * c.normal;
+		c.normalImpulse = total;
+
+		if (c.a >= 0)
+		{
+			m_velocity[c.a] -= m_invMass[c.a] * impulse;
+			m_rotation[c.a] -= m_invMoment[c.a] * Cross(c.rA, impulse);
+		}
+		if (c.b >= 0)
+		{
+			m_velocity[c.b] += m_invMass[c.b] * impulse;
+			m_rotation[c.b] += m_invMoment[c.b] * Cross(c.rB, impulse);
+		}
+	}
+}
+
+// the same again for penetration, but with velocities that only last for this step so pushing bodies apart
+// doesn't leave them flying off afterwards
+void ContactSolver::SolvePositions()
+{
+	for (auto& c : m_constraints)
+	{
+		glm::vec2 velocityA = c.a >= 0 ? PointVelocity(m_pseudoVelocity[c.a], m_pseudoRotation[c.a], c.rA) : glm::vec2(0, 0);
+		glm::vec2 velocityB = c.b >= 0 ? PointVelocity(m_pseudoVelocity[c.b], m_pseudoRotation[c.b], c.rB) : glm::vec2(0, 0);
+		float closing = glm::dot(velocityB - velocityA, c.normal);
+
+		float total = fmaxf(c.positionImpulse + c.normalMass * (c.bias - closing), 0.0f);
+		glm::vec2 impulse = (total - c.positionImpulse) * c.normal;
+		c.positionImpulse = total;
+
+		if (c.a >= 0)
+		{
+			m_pseudoVelocity[c.a] -= m_invMass[c.a] * impulse;
+			m_pseudoRotation[c.a] -= m_invMoment[c.a] * Cross(c.rA, impulse);
+		}
+		if (c.b >= 0)
+		{
+			m_pseudoVelocity[c.b] += m_invMass[c.b] * impulse;
+			m_pseudoRotation[c.b] += m_invMoment[c.b] * Cross(c.rB, impulse);
+		}
+	}
+}
\ No newline at end of file
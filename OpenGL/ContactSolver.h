@@ -0,0 +1,68 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+#include <vector>
+
+#include "Contact.h"
+
+class BodyStore;
+class DebugDraw;
+
+// one contact point ready for solving. Everything that stays the same between iterations is worked out up front.
+struct ContactConstraint
+{
+	// slots in the solver's body arrays, -1 for planes and fixed bodies
+	int a, b;
+	// from a towards b
+	glm::vec2 normal;
+	// from each centre of mass to the contact point
+	glm::vec2 rA, rB;
+	// 1 / the effective mass along the normal
+	float normalMass;
+	// speed the points should be moving apart once solved, from restitution
+	float targetVelocity;
+	// speed the position correction pushes them apart at
+	float bias;
+	float normalImpulse;
+	float positionImpulse;
+	// where the total impulse goes back to, for warm starting next step
+	ContactPoint* point;
+};
+
+// sequential impulse solver. An island's contacts are turned into a flat array of point constraints, then the impulse
+// at each point is nudged in turn, over and over, until they all agree. The impulses are totals for the whole step,
+// clamped so they only ever push, and start off from last step's. Penetration is fixed separately with pseudo
+// velocities that move the bodies without adding any energy.
+class ContactSolver
+{
+public:
+	float dt = 1.0f / 60.0f;
+	int velocityIterations = 8;
+	int positionIterations = 3;
+
+	// optional, contact points are drawn into it
+	DebugDraw* debugDraw = nullptr;
+
+	// number of manifolds that were solved
+	int numSolved = 0;
+
+	// bodies are the island's body indices, contacts its manifolds. bodySlot maps a body index to its place in
+	// the island and is only touched for the island's own bodies.
+	void SolveIsland(BodyStore& store, const int* bodies, int numBodies, int* bodySlot,
+		std::vector<ContactManifold>& manifolds, const int* contacts, int numContacts);
+
+private:
+	void Prepare(BodyStore& store, const int* bodySlot, std::vector<ContactManifold>& manifolds, const int* contacts, int numContacts);
+	void WarmStart();
+	void SolveVelocities();
+	void SolvePositions();
+
+	std::vector<ContactConstraint> m_constraints;
+
+	// the island's bodies, copied out of the store for the duration of the solve
+	std::vector<glm::vec2> m_velocity;
+	std::vector<float> m_rotation;
+	std::vector<glm::vec2> m_pseudoVelocity;
+	std::vector<float> m_pseudoRotation;
+	std::vector<float> m_invMass;
+	std::vector<float> m_invMoment;
+};
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+
+// interface the physics objects use to draw themselves, so the simulation itself
+// never depends on OpenGL. The viewer implements it with Gizmos, headless runs pass nothing.
+class DebugDraw
+{
+public:
+	virtual void add2DLine(glm::vec2 start, glm::vec2 end, glm::vec4 colour) = 0;
+	virtual void add2DTri(glm::vec2 p1, glm::vec2 p2, glm::vec2 p3, glm::vec4 colour) = 0;
+	virtual void add2DCircle(glm::vec2 centre, float radius, int segments, glm::vec4 colour) = 0;
+
+	// count lines at once, from points[2i] to points[2i + 1]
+	virtual void add2DLines(const glm::vec2* points, int count, glm::vec4 colour)
+	{
+		for (int i = 0; i < count; i++)
+			add2DLine(points[2 * i], points[2 * i + 1], colour);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include "DebugDrawBuffer.h"
+
+void DebugDrawBuffer::add2DLine(glm::vec2 start, glm::vec2 end, glm::vec4 colour)
+{
+	m_lines.push_back({ start, end, colour });
+}
+
+void DebugDrawBuffer::add2DTri(glm::vec2 p1, glm::vec2 p2, glm::vec2 p3, glm::vec4 colour)
+{
+	m_tris.push_back({ p1, p2, p3, colour });
+}
+
+void DebugDrawBuffer::add2DCircle(glm::vec2 centre, float radius, int segments, glm::vec4 colour)
+{
+	m_circles.push_back({ centre, radius, segments, colour });
+}
+
+void DebugDrawBuffer::Replay(DebugDraw* draw)
+{
+	for (auto& line : m_lines)
+		draw->add2DLine(line.start, line.end, line.colour);
+	for (auto& tri : m_tris)
+		draw->add2DTri(tri.p1, tri.p2, tri.p3, tri.colour);
+	for (auto& circle : m_circles)
+		draw->add2DCircle(circle.centre, circle.radius, circle.segments, circle.colour);
+}
+
+void DebugDrawBuffer::Clear()
+{
+	m_lines.clear();
+	m_tris.clear();
+	m_circles.clear();
+}
\ No newline at end of file
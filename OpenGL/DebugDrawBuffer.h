@@ -0,0 +1,43 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+#include <vector>
+
+#include "DebugDraw.h"
+
+// records debug drawing so it can be played back later onto another DebugDraw. Lets worker threads
+// draw without touching the real one.
+class DebugDrawBuffer : public DebugDraw
+{
+public:
+	virtual void add2DLine(glm::vec2 start, glm::vec2 end, glm::vec4 colour);
+	virtual void add2DTri(glm::vec2 p1, glm::vec2 p2, glm::vec2 p3, glm::vec4 colour);
+	virtual void add2DCircle(glm::vec2 centre, float radius, int segments, glm::vec4 colour);
+
+	void Replay(DebugDraw* draw);
+	void Clear();
+
+private:
+	struct Line
+	{
+		glm::vec2 start, end;
+		glm::vec4 colour;
+	};
+
+	struct Tri
+	{
+		glm::vec2 p1, p2, p3;
+		glm::vec4 colour;
+	};
+
+	struct Circle
+	{
+		glm::vec2 centre;
+		float radius;
+		int segments;
+		glm::vec4 colour;
+	};
+
+	std::vector<Line> m_lines;
+	std::vector<Tri> m_tris;
+	std::vector<Circle> m_circles;
+};
\ No newline at end of file
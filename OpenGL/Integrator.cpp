@@ -0,0 +1,401 @@
+#include <glm/glm/glm.hpp>
+#include <math.h>
+
+#include "Integrator.h"
+#include "BodyStore.h"
+#include "Simd.h"
+
+
+// past this the range reduction in SinCos loses accuracy, so angles get wrapped first
+static const float MAX_REDUCED_ANGLE = 8192.0f;
+
+// cephes sinf/cosf constants
+static const float FOPI = 1.27323954473516f; // 4 / pi
+static const float DP1 = 0.78515625f;
+static const float DP2 = 2.4187564849853515625e-4f;
+static const float DP3 = 3.77489497744594108e-8f;
+static const float SINCOF_P0 = -1.9515295891e-4f;
+static const float SINCOF_P1 = 8.3321608736e-3f;
+static const float SINCOF_P2 = -1.6666654611e-1f;
+static const float COSCOF_P0 = 2.443315711809948e-5f;
+static const float COSCOF_P1 = -1.388731625493765e-3f;
+static const float COSCOF_P2 = 4.166664568298827e-2f;
+
+// a body has to stay under these for PhysicsWorld::timeToSleep before its island sleeps. This used to be 0.8,
+// when a body dropped out of the simulation the first step it was under it; held that long, 0.8 freezes bodies
+// that are still visibly sliding or rolling, so it's much lower now
+static const float SLEEP_VELOCITY = 0.1f;
+static const float SLEEP_ROTATION = 0.005f;
+static const float DAMPING = 0.99f;
+
+void Integrator::SinCos(float x, float& s, float& c)
+{
+	if (fabsf(x) > MAX_REDUCED_ANGLE)
+		x = (float)fmod((double)x, 6.283185307179586);
+
+	bool negativeSin = x < 0;
+	x = fabsf(x);
+
+	// which octant are we in. Map zero to one and so on, so we're working with the nearest multiple of pi/4
+	int j = (int)(x * FOPI);
+	j = (j + 1) & ~1;
+	float y = (float)j;
+
+	if (j & 4)
+		negativeSin = !negativeSin;
+	bool negativeCos = ((~(j - 2)) & 4) != 0;
+	bool sinPoly = (j & 2) == 0;
+
+	// extended precision modular arithmetic
+	x = ((x - y * DP1) - y * DP2) - y * DP3;
+	float z = x * x;
+
+	float y1 = COSCOF_P0 * z + COSCOF_P1;
+	y1 = y1 * z + COSCOF_P2;
+	y1 = y1 * z;
+	y1 = y1 * z;
+	y1 = y1 - z * 0.5f;
+	y1 = y1 + 1.0f;
+
+	float y2 = SINCOF_P0 * z + SINCOF_P1;
+	y2 = y2 * z + SINCOF_P2;
+	y2 = y2 * z;
+	y2 = y2 * x;
+	y2 = y2 + x;
+
+	s = sinPoly ? y2 : y1;
+	c = sinPoly ? y1 : y2;
+	if (negativeSin)
+		s = -s;
+	if (negativeCos)
+		c = -c;
+}
+
+// one body, used for the whole range by the scalar path and for the left overs by the others
+static void IntegrateBody(BodyStore& bodies, int i, float dt, glm::vec2 gravityDt)
+{
+	glm::vec2& position = bodies.position[i];
+	glm::vec2& velocity = bodies.velocity[i];
+
+	bodies.angle[i] += bodies.rotation[i] * dt;
+	position.x += velocity.x * dt;
+	position.y += velocity.y * dt;
+
+	//apply air resistance
+	velocity.x *= DAMPING;
+	velocity.y *= DAMPING;
+	bodies.rotation[i] *= DAMPING;
+
+	// time spent slow enough to sleep. The world puts islands to sleep once all their bodies have been for long enough
+	bool slow = sqrtf(velocity.x * velocity.x + velocity.y * velocity.y) < SLEEP_VELOCITY && fabsf(bodies.rotation[i]) < SLEEP_ROTATION;
+	bodies.sleepTime[i] = slow ? bodies.sleepTime[i] + dt : 0.0f;
+
+	// apply gravity to the centre of mass as a straight acceleration
+	velocity.x += gravityDt.x;
+	velocity.y += gravityDt.y;
+
+	//store the local axes
+	float cs, sn;
+	Integrator::SinCos(bodies.angle[i], sn, cs);
+	bodies.localX[i] = glm::vec2(cs, sn);
+	bodies.localY[i] = glm::vec2(-sn, cs);
+}
+
+#ifdef SIMD_X86
+
+TARGET_SSE2 static void SinCos4(__m128 x, __m128& s, __m128& c)
+{
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+
+	// angles too big for the range reduction go through the scalar version one at a time
+	if (_mm_movemask_ps(_mm_cmpgt_ps(_mm_andnot_ps(signMask, x), _mm_set1_ps(MAX_REDUCED_ANGLE))))
+	{
+		float in[4], outS[4], outC[4];
+		_mm_storeu_ps(in, x);
+		for (int k = 0; k < 4; k++)
+			Integrator::SinCos(in[k], outS[k], outC[k]);
+		s = _mm_loadu_ps(outS);
+		c = _mm_loadu_ps(outC);
+		return;
+	}
+
+	__m128 signSin = _mm_and_ps(x, signMask);
+	x = _mm_andnot_ps(signMask, x);
+
+	__m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(FOPI)));
+	j = _mm_add_epi32(j, _mm_set1_epi32(1));
+	j = _mm_and_si128(j, _mm_set1_epi32(~1));
+	__m128 y = _mm_cvtepi32_ps(j);
+
+	__m128 swapSignSin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29));
+	__m128 sinPoly = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+	__m128 signCos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+	signSin = _mm_xor_ps(signSin, swapSignSin);
+
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP1)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP2)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP3)));
+	__m128 z = _mm_mul_ps(x, x);
+
+	__m128 y1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COSCOF_P0), z), _mm_set1_ps(COSCOF_P1));
+	y1 = _mm_add_ps(_mm_mul_ps(y1, z), _mm_set1_ps(COSCOF_P2));
+	y1 = _mm_mul_ps(y1, z);
+	y1 = _mm_mul_ps(y1, z);
+	y1 = _mm_sub_ps(y1, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+	y1 = _mm_add_ps(y1, _mm_set1_ps(1.0f));
+
+	__m128 y2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SINCOF_P0), z), _mm_set1_ps(SINCOF_P1));
+	y2 = _mm_add_ps(_mm_mul_ps(y2, z), _mm_set1_ps(SINCOF_P2));
+	y2 = _mm_mul_ps(y2, z);
+	y2 = _mm_mul_ps(y2, x);
+	y2 = _mm_add_ps(y2, x);
+
+	s = _mm_or_ps(_mm_and_ps(sinPoly, y2), _mm_andnot_ps(sinPoly, y1));
+	c = _mm_or_ps(_mm_and_ps(sinPoly, y1), _mm_andnot_ps(sinPoly, y2));
+	s = _mm_xor_ps(s, signSin);
+	c = _mm_xor_ps(c, signCos);
+}
+
+// four bodies at a time. Positions and velocities are interleaved xyxy, so each pair of registers holds four bodies
+TARGET_SSE2 static void IntegrateSSE2(BodyStore& bodies, int begin, int end, float dt, glm::vec2 gravityDt)
+{
+	float* position = (float*)bodies.position.data();
+	float* velocity = (float*)bodies.velocity.data();
+	float* angle = bodies.angle.data();
+	float* rotation = bodies.rotation.data();
+	float* sleepTime = bodies.sleepTime.data();
+	float* localX = (float*)bodies.localX.data();
+	float* localY = (float*)bodies.localY.data();
+
+	const __m128 vdt = _mm_set1_ps(dt);
+	const __m128 damping = _mm_set1_ps(DAMPING);
+	const __m128 gdt = _mm_setr_ps(gravityDt.x, gravityDt.y, gravityDt.x, gravityDt.y);
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+
+	int i = begin;
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 p0 = _mm_loadu_ps(position + 2 * i);
+		__m128 p1 = _mm_loadu_ps(position + 2 * i + 4);
+		__m128 v0 = _mm_loadu_ps(velocity + 2 * i);
+		__m128 v1 = _mm_loadu_ps(velocity + 2 * i + 4);
+		__m128 ang = _mm_loadu_ps(angle + i);
+		__m128 rot = _mm_loadu_ps(rotation + i);
+
+		ang = _mm_add_ps(ang, _mm_mul_ps(rot, vdt));
+		p0 = _mm_add_ps(p0, _mm_mul_ps(v0, vdt));
+		p1 = _mm_add_ps(p1, _mm_mul_ps(v1, vdt));
+
+		__m128 dv0 = _mm_mul_ps(v0, damping);
+		__m128 dv1 = _mm_mul_ps(v1, damping);
+		__m128 drot = _mm_mul_ps(rot, damping);
+
+		// speed of each body from the damped velocity
+		__m128 sq0 = _mm_mul_ps(dv0, dv0);
+		__m128 sq1 = _mm_mul_ps(dv1, dv1);
+		__m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_shuffle_ps(sq0, sq1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(sq0, sq1, _MM_SHUFFLE(3, 1, 3, 1))));
+		__m128 sleepy = _mm_and_ps(_mm_cmplt_ps(speed, _mm_set1_ps(SLEEP_VELOCITY)), _mm_cmplt_ps(_mm_andnot_ps(signMask, drot), _mm_set1_ps(SLEEP_ROTATION)));
+
+		__m128 sleep = _mm_and_ps(sleepy, _mm_add_ps(_mm_loadu_ps(sleepTime + i), vdt));
+
+		v0 = _mm_add_ps(dv0, gdt);
+		v1 = _mm_add_ps(dv1, gdt);
+
+		_mm_storeu_ps(position + 2 * i, p0);
+		_mm_storeu_ps(position + 2 * i + 4, p1);
+		_mm_storeu_ps(velocity + 2 * i, v0);
+		_mm_storeu_ps(velocity + 2 * i + 4, v1);
+		_mm_storeu_ps(angle + i, ang);
+		_mm_storeu_ps(rotation + i, drot);
+		_mm_storeu_ps(sleepTime + i, sleep);
+
+		__m128 sn, cs;
+		SinCos4(ang, sn, cs);
+		__m128 negSn = _mm_xor_ps(sn, signMask);
+		_mm_storeu_ps(localX + 2 * i, _mm_unpacklo_ps(cs, sn));
+		_mm_storeu_ps(localX + 2 * i + 4, _mm_unpackhi_ps(cs, sn));
+		_mm_storeu_ps(localY + 2 * i, _mm_unpacklo_ps(negSn, cs));
+		_mm_storeu_ps(localY + 2 * i + 4, _mm_unpackhi_ps(negSn, cs));
+	}
+
+	for (; i < end; i++)
+		IntegrateBody(bodies, i, dt, gravityDt);
+}
+
+TARGET_AVX2 static void SinCos8(__m256 x, __m256& s, __m256& c)
+{
+	const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+
+	if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_andnot_ps(signMask, x), _mm256_set1_ps(MAX_REDUCED_ANGLE), _CMP_GT_OQ)))
+	{
+		float in[8], outS[8], outC[8];
+		_mm256_storeu_ps(in, x);
+		for (int k = 0; k < 8; k++)
+			Integrator::SinCos(in[k], outS[k], outC[k]);
+		s = _mm256_loadu_ps(outS);
+		c = _mm256_loadu_ps(outC);
+		return;
+	}
+
+	__m256 signSin = _mm256_and_ps(x, signMask);
+	x = _mm256_andnot_ps(signMask, x);
+
+	__m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(FOPI)));
+	j = _mm256_add_epi32(j, _mm256_set1_epi32(1));
+	j = _mm256_and_si256(j, _mm256_set1_epi32(~1));
+	__m256 y = _mm256_cvtepi32_ps(j);
+
+	__m256 swapSignSin = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29));
+	__m256 sinPoly = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+	__m256 signCos = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+	signSin = _mm256_xor_ps(signSin, swapSignSin);
+
+	x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP1)));
+	x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP2)));
+	x = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP3)));
+	__m256 z = _mm256_mul_ps(x, x);
+
+	__m256 y1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COSCOF_P0), z), _mm256_set1_ps(COSCOF_P1));
+	y1 = _mm256_add_ps(_mm256_mul_ps(y1, z), _mm256_set1_ps(COSCOF_P2));
+	y1 = _mm256_mul_ps(y1, z);
+	y1 = _mm256_mul_ps(y1, z);
+	y1 = _mm256_sub_ps(y1, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+	y1 = _mm256_add_ps(y1, _mm256_set1_ps(1.0f));
+
+	__m256 y2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SINCOF_P0), z), _mm256_set1_ps(SINCOF_P1));
+	y2 = _mm256_add_ps(_mm256_mul_ps(y2, z), _mm256_set1_ps(SINCOF_P2));
+	y2 = _mm256_mul_ps(y2, z);
+	y2 = _mm256_mul_ps(y2, x);
+	y2 = _mm256_add_ps(y2, x);
+
+	s = _mm256_blendv_ps(y1, y2, sinPoly);
+	c = _mm256_blendv_ps(y2, y1, sinPoly);
+	s = _mm256_xor_ps(s, signSin);
+	c = _mm256_xor_ps(c, signCos);
+}
+
+// eight bodies at a time. Same as the SSE2 version, except the 256 bit shuffles work within 128 bit
+// halves, so a few extra permutes are needed to keep bodies in order
+TARGET_AVX2 static void IntegrateAVX2(BodyStore& bodies, int begin, int end, float dt, glm::vec2 gravityDt)
+{
+	float* position = (float*)bodies.position.data();
+	float* velocity = (float*)bodies.velocity.data();
+	float* angle = bodies.angle.data();
+	float* rotation = bodies.rotation.data();
+	float* sleepTime = bodies.sleepTime.data();
+	float* localX = (float*)bodies.localX.data();
+	float* localY = (float*)bodies.localY.data();
+
+	const __m256 vdt = _mm256_set1_ps(dt);
+	const __m256 damping = _mm256_set1_ps(DAMPING);
+	const __m256 gdt = _mm256_setr_ps(gravityDt.x, gravityDt.y, gravityDt.x, gravityDt.y, gravityDt.x, gravityDt.y, gravityDt.x, gravityDt.y);
+	const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+
+	int i = begin;
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 p0 = _mm256_loadu_ps(position + 2 * i);
+		__m256 p1 = _mm256_loadu_ps(position + 2 * i + 8);
+		__m256 v0 = _mm256_loadu_ps(velocity + 2 * i);
+		__m256 v1 = _mm256_loadu_ps(velocity + 2 * i + 8);
+		__m256 ang = _mm256_loadu_ps(angle + i);
+		__m256 rot = _mm256_loadu_ps(rotation + i);
+
+		ang = _mm256_add_ps(ang, _mm256_mul_ps(rot, vdt));
+		p0 = _mm256_add_ps(p0, _mm256_mul_ps(v0, vdt));
+		p1 = _mm256_add_ps(p1, _mm256_mul_ps(v1, vdt));
+
+		__m256 dv0 = _mm256_mul_ps(v0, damping);
+		__m256 dv1 = _mm256_mul_ps(v1, damping);
+		__m256 drot = _mm256_mul_ps(rot, damping);
+
+		// the in-lane shuffles give bodies in the order 0 1 4 5 2 3 6 7, so swap the middle pairs back
+		__m256 sq0 = _mm256_mul_ps(dv0, dv0);
+		__m256 sq1 = _mm256_mul_ps(dv1, dv1);
+		__m256 speedSq = _mm256_add_ps(_mm256_shuffle_ps(sq0, sq1, _MM_SHUFFLE(2, 0, 2, 0)), _mm256_shuffle_ps(sq0, sq1, _MM_SHUFFLE(3, 1, 3, 1)));
+		speedSq = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(speedSq), _MM_SHUFFLE(3, 1, 2, 0)));
+		__m256 speed = _mm256_sqrt_ps(speedSq);
+		__m256 sleepy = _mm256_and_ps(_mm256_cmp_ps(speed, _mm256_set1_ps(SLEEP_VELOCITY), _CMP_LT_OQ),
+			_mm256_cmp_ps(_mm256_andnot_ps(signMask, drot), _mm256_set1_ps(SLEEP_ROTATION), _CMP_LT_OQ));
+
+		__m256 sleep = _mm256_and_ps(sleepy, _mm256_add_ps(_mm256_loadu_ps(sleepTime + i), vdt));
+
+		v0 = _mm256_add_ps(dv0, gdt);
+		v1 = _mm256_add_ps(dv1, gdt);
+
+		_mm256_storeu_ps(position + 2 * i, p0);
+		_mm256_storeu_ps(position + 2 * i + 8, p1);
+		_mm256_storeu_ps(velocity + 2 * i, v0);
+		_mm256_storeu_ps(velocity + 2 * i + 8, v1);
+		_mm256_storeu_ps(angle + i, ang);
+		_mm256_storeu_ps(rotation + i, drot);
+		_mm256_storeu_ps(sleepTime + i, sleep);
+
+		__m256 sn, cs;
+		SinCos8(ang, sn, cs);
+		__m256 negSn = _mm256_xor_ps(sn, signMask);
+		__m256 xLo = _mm256_unpacklo_ps(cs, sn), xHi = _mm256_unpackhi_ps(cs, sn);
+		__m256 yLo = _mm256_unpacklo_ps(negSn, cs), yHi = _mm256_unpackhi_ps(negSn, cs);
+		_mm256_storeu_ps(localX + 2 * i, _mm256_permute2f128_ps(xLo, xHi, 0x20));
+		_mm256_storeu_ps(localX + 2 * i + 8, _mm256_permute2f128_ps(xLo, xHi, 0x31));
+		_mm256_storeu_ps(localY + 2 * i, _mm256_permute2f128_ps(yLo, yHi, 0x20));
+		_mm256_storeu_ps(localY + 2 * i + 8, _mm256_permute2f128_ps(yLo, yHi, 0x31));
+	}
+
+	for (; i < end; i++)
+		IntegrateBody(bodies, i, dt, gravityDt);
+}
+
+#endif
+
+Integrator::InstructionSet Integrator::Best()
+{
+#ifdef SIMD_X86
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] >= 7)
+	{
+		// AVX2 needs the CPU to support it and the OS to save the YMM registers
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		__cpuidex(info, 7, 0);
+		bool avx2 = (info[1] & (1 << 5)) != 0;
+		if (osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6)
+			return AVX2;
+	}
+	return SSE2;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return SSE2;
+	return SCALAR;
+#endif
+#else
+	return SCALAR;
+#endif
+}
+
+void Integrator::Integrate(InstructionSet set, BodyStore& bodies, int begin, int end, float dt, glm::vec2 gravity)
+{
+	glm::vec2 gravityDt = gravity * dt;
+
+#ifdef SIMD_X86
+	if (set == AVX2)
+	{
+		IntegrateAVX2(bodies, begin, end, dt, gravityDt);
+		return;
+	}
+	if (set == SSE2)
+	{
+		IntegrateSSE2(bodies, begin, end, dt, gravityDt);
+		return;
+	}
+#endif
+
+	for (int i = begin; i < end; i++)
+		IntegrateBody(bodies, i, dt, gravityDt);
+}
\ No newline at end of file
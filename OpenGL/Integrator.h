@@ -0,0 +1,27 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+
+class BodyStore;
+
+// moves the bodies in a BodyStore on by one time step, several bodies at a time where the CPU allows.
+// Every path does the same arithmetic in the same order, and they all share one sin/cos approximation,
+// so the results are bit for bit the same whichever instruction set ends up being used.
+class Integrator
+{
+public:
+	enum InstructionSet
+	{
+		SCALAR,
+		SSE2,
+		AVX2,
+	};
+
+	// the best instruction set this CPU and OS support
+	static InstructionSet Best();
+
+	// integrates bodies [begin, end), which must all be awake
+	static void Integrate(InstructionSet set, BodyStore& bodies, int begin, int end, float dt, glm::vec2 gravity);
+
+	// polynomial sin and cos, accurate to a couple of ulp
+	static void SinCos(float x, float& s, float& c);
+};
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "JobSystem.h"
+
+JobSystem::JobSystem(int numThreads)
+{
+	if (numThreads <= 0)
+		numThreads = (int)std::thread::hardware_concurrency();
+	if (numThreads <= 0)
+		numThreads = 1;
+
+	m_remaining = 0;
+	for (int i = 0; i < numThreads; i++)
+		m_queues.push_back(new Queue());
+
+	// queue 0 belongs to whoever calls ParallelFor
+	for (int i = 1; i < numThreads; i++)
+		m_threads.push_back(std::thread(&JobSystem::WorkerMain, this, i));
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeLock);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	for (auto& thread : m_threads)
+		thread.join();
+	for (auto queue : m_queues)
+		delete queue;
+}
+
+void JobSystem::ParallelFor(int count, const std::function<void(int)>& job)
+{
+	if (count <= 0)
+		return;
+
+	if (m_threads.empty() || count == 1)
+	{
+		for (int i = 0; i < count; i++)
+			job(i);
+		return;
+	}
+
+	m_job = &job;
+	m_remaining = count;
+
+	// deal the jobs out round robin, stealing evens things up if some turn out bigger than others
+	int numQueues = NumThreads();
+	for (int q = 0; q < numQueues; q++)
+	{
+		std::lock_guard<std::mutex> lock(m_queues[q]->lock);
+		for (int i = q; i < count; i += numQueues)
+			m_queues[q]->jobs.push_back(i);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeLock);
+		m_generation++;
+	}
+	m_wake.notify_all();
+
+	while (RunOne(0)) {}
+
+	// everything's been taken, wait for the stragglers to finish
+	while (m_remaining.load(std::memory_order_acquire) > 0)
+		std::this_thread::yield();
+	m_job = nullptr;
+}
+
+void JobSystem::WorkerMain(int index)
+{
+	unsigned int seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_wakeLock);
+			m_wake.wait(lock, [&] { return m_quit || m_generation != seen; });
+			if (m_quit)
+				return;
+			seen = m_generation;
+		}
+
+		while (RunOne(index)) {}
+	}
+}
+
+bool JobSystem::RunOne(int index)
+{
+	int job = -1;
+
+	// newest first from our own queue
+	{
+		Queue* queue = m_queues[index];
+		std::lock_guard<std::mutex> lock(queue->lock);
+		if (!queue->jobs.empty())
+		{
+			job = queue->jobs.back();
+			queue->jobs.pop_back();
+		}
+	}
+
+	// then oldest first from everyone else's
+	int numQueues = NumThreads();
+	for (int i = 1; job < 0 && i < numQueues; i++)
+	{
+		Queue* queue = m_queues[(index + i) % numQueues];
+		std::lock_guard<std::mutex> lock(queue->lock);
+		if (!queue->jobs.empty())
+		{
+			job = queue->jobs.front();
+			queue->jobs.pop_front();
+		}
+	}
+
+	if (job < 0)
+		return false;
+
+	(*m_job)(job);
+	m_remaining.fetch_sub(1, std::memory_order_release);
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a fixed set of worker threads, each with its own queue of jobs. A thread takes work from the back of its own
+// queue and, once that's empty, steals from the front of everyone else's.
+class JobSystem
+{
+public:
+	// numThreads includes the calling thread, so 1 runs everything inline. 0 means one per core.
+	JobSystem(int numThreads = 0);
+	~JobSystem();
+
+	int NumThreads() { return (int)m_queues.size(); }
+
+	// calls job(i) for every i in [0, count) and returns once they've all finished. The calling thread joins in.
+	void ParallelFor(int count, const std::function<void(int)>& job);
+
+private:
+	struct Queue
+	{
+		std::mutex lock;
+		std::deque<int> jobs;
+	};
+
+	void WorkerMain(int index);
+	bool RunOne(int index);
+
+	std::vector<Queue*> m_queues;
+	std::vector<std::thread> m_threads;
+
+	const std::function<void(int)>* m_job = nullptr;
+	std::atomic<int> m_remaining;
+
+	// workers sleep on this between calls to ParallelFor
+	std::mutex m_wakeLock;
+	std::condition_variable m_wake;
+	unsigned int m_generation = 0;
+	bool m_quit = false;
+};
\ No newline at end of file
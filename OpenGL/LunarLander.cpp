@@ -1,38 +1,34 @@
-#include <gl_core_4_4.h>
-#include <glm\glm\glm.hpp>
-#include <aie/Gizmos.h>
+#include <glm/glm/glm.hpp>
 
-#include "PhysicsApplication.h"
+#include "PhysicsWorld.h"
 #include "LunarLander.h"
+#include "DebugDraw.h"
 
-void LunarLander::Update(float dt)
+// seconds each puff of exhaust lasts
+static const float EXHAUST_LIFE = 1.5f;
+
+void LunarLander::Update(float)
 {
-	Circle::Update(dt);
+	glm::vec2 position = Position(), localX = LocalX(), localY = LocalY();
 
 	pod1 = position + (-localX - 0.5f * localY)*radius;
 	pod2 = position + (localX - 0.5f * localY)*radius;
 
-	GLFWwindow* window = PhysicsApplication::theApp->window;
-
-	if (glfwGetKey(window, GLFW_KEY_Z))
+	if (world->input & PhysicsWorld::INPUT_THRUST_LEFT)
 	{
-		Circle* c = new Circle(pod1 + 0.5f*localY*radius, -10 * localY, 0.1f, 0);
-		c->lifeSpan = 100;
-		PhysicsApplication::theApp->m_physicsObjects.push_front(c);
+		world->particleSystem.Emit(pod1 + 0.5f*localY*radius, -10.0f * localY, EXHAUST_LIFE);
 		this->ApplyForce(localY, pod1);
 	}
-	if (glfwGetKey(window, GLFW_KEY_C))
+	if (world->input & PhysicsWorld::INPUT_THRUST_RIGHT)
 	{
-		Circle* c = new Circle(pod2 + 0.5f*localY*radius, -10*localY, 0.1f, 0);
-		c->lifeSpan = 100;
-		PhysicsApplication::theApp->m_physicsObjects.push_front(c);
+		world->particleSystem.Emit(pod2 + 0.5f*localY*radius, -10.0f*localY, EXHAUST_LIFE);
 		this->ApplyForce(localY, pod2);
 	}
 }
 
-void LunarLander::Draw()
+void LunarLander::Draw(DebugDraw* draw)
 {
-	Circle::Draw();
-	Gizmos::add2DCircle(pod1, radius*0.5f, 16, vec4(0,1,1,1));
-	Gizmos::add2DCircle(pod2, radius*0.5f, 16, vec4(0, 1, 1, 1));
-}
+	Circle::Draw(draw);
+	draw->add2DCircle(DrawToWorld(glm::vec2(-1, -0.5f) * radius), radius*0.5f, 16, glm::vec4(0,1,1,1));
+	draw->add2DCircle(DrawToWorld(glm::vec2(1, -0.5f) * radius), radius*0.5f, 16, glm::vec4(0, 1, 1, 1));
+}
\ No newline at end of file
@@ -7,22 +7,23 @@ public:
 	LunarLander() {}
 	LunarLander(glm::vec2 p)
 	{
-		position = p;
+		def.position = p;
 		radius = 1;
-		fixed = false;
-		awake = true;
+		def.fixed = false;
+		def.awake = true;
 		radius = 1;
-		mass = 2;
-		angle = 0; 
-		rotation = 0;
+		def.mass = 2;
+		def.angle = 0; 
+		def.rotation = 0;
 		oType = CIRCLE;
-		moment = 15.0f * 0.5f* mass * radius*radius;
+		def.moment = 15.0f * 0.5f* def.mass * radius*radius;
 	}
 
 	virtual void Update(float dt);
-	virtual void Draw();
+	virtual bool HasUpdate() { return true; }
+	virtual void Draw(DebugDraw* draw);
 
-	vec2 pod1;
-	vec2 pod2;
+	glm::vec2 pod1;
+	glm::vec2 pod2;
 
-};
+};
\ No newline at end of file
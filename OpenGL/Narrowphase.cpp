@@ -0,0 +1,339 @@
+#include <glm/glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+
+#include "Narrowphase.h"
+#include "BodyStore.h"
+#include "JobSystem.h"
+#include "Collision.h"
+#include "Plane.h"
+#include "Circle.h"
+#include "Box.h"
+#include "Simd.h"
+
+// pairs or bodies tested per job. Also the size of the scratch arrays the circle kernels gather into
+static const int CHUNK_SIZE = 128;
+// the SIMD filters compare squared distances where the full tests take a square root, which can round the other
+// way right on the edge. Letting through anything within this factor of touching means nothing touching is ever lost
+static const float FILTER_MARGIN = 1.001f;
+
+typedef std::chrono::steady_clock Clock;
+
+static double MillisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// finds which of count pairs of circles are close enough to be touching and lists them in hits. Returns how many
+static int FilterPairsScalar(const float* ax, const float* ay, const float* bx, const float* by, const float* reach,
+	int begin, int count, int* hits, int numHits)
+{
+	for (int i = begin; i < count; i++)
+	{
+		float dx = bx[i] - ax[i], dy = by[i] - ay[i];
+		if (dx*dx + dy*dy < reach[i] * reach[i])
+			hits[numHits++] = i;
+	}
+	return numHits;
+}
+
+// finds which of count circles are close enough to the plane to be touching it. Either side counts for two sided planes
+static int FilterPlaneScalar(const float* x, const float* y, const float* reach, int begin, int count, Plane* plane,
+	int* hits, int numHits)
+{
+	for (int i = begin; i < count; i++)
+	{
+		float d = (x[i] - plane->origin.x) * plane->normal.x + (y[i] - plane->origin.y) * plane->normal.y;
+		if (!plane->oneSided)
+			d = fabsf(d);
+		if (d < reach[i])
+			hits[numHits++] = i;
+	}
+	return numHits;
+}
+
+#ifdef SIMD_X86
+
+TARGET_SSE2 static int FilterPairsSSE2(const float* ax, const float* ay, const float* bx, const float* by,
+	const float* reach, int count, int* hits)
+{
+	int numHits = 0;
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(bx + i), _mm_loadu_ps(ax + i));
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(by + i), _mm_loadu_ps(ay + i));
+		__m128 r = _mm_loadu_ps(reach + i);
+		__m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		int mask = _mm_movemask_ps(_mm_cmplt_ps(distSq, _mm_mul_ps(r, r)));
+		for (int k = 0; mask; k++, mask >>= 1)
+		{
+			if (mask & 1)
+				hits[numHits++] = i + k;
+		}
+	}
+	return FilterPairsScalar(ax, ay, bx, by, reach, i, count, hits, numHits);
+}
+
+TARGET_SSE2 static int FilterPlaneSSE2(const float* x, const float* y, const float* reach, int count, Plane* plane, int* hits)
+{
+	const __m128 ox = _mm_set1_ps(plane->origin.x), oy = _mm_set1_ps(plane->origin.y);
+	const __m128 nx = _mm_set1_ps(plane->normal.x), ny = _mm_set1_ps(plane->normal.y);
+	// clearing the sign bit for two sided planes, so either side passes
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(plane->oneSided ? -1 : 0x7fffffff));
+
+	int numHits = 0;
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 d = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x + i), ox), nx), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(y + i), oy), ny));
+		int mask = _mm_movemask_ps(_mm_cmplt_ps(_mm_and_ps(d, absMask), _mm_loadu_ps(reach + i)));
+		for (int k = 0; mask; k++, mask >>= 1)
+		{
+			if (mask & 1)
+				hits[numHits++] = i + k;
+		}
+	}
+	return FilterPlaneScalar(x, y, reach, i, count, plane, hits, numHits);
+}
+
+TARGET_AVX2 static int FilterPairsAVX2(const float* ax, const float* ay, const float* bx, const float* by,
+	const float* reach, int count, int* hits)
+{
+	int numHits = 0;
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(bx + i), _mm256_loadu_ps(ax + i));
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(by + i), _mm256_loadu_ps(ay + i));
+		__m256 r = _mm256_loadu_ps(reach + i);
+		__m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		int mask = _mm256_movemask_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(r, r), _CMP_LT_OQ));
+		for (int k = 0; mask; k++, mask >>= 1)
+		{
+			if (mask & 1)
+				hits[numHits++] = i + k;
+		}
+	}
+	return FilterPairsScalar(ax, ay, bx, by, reach, i, count, hits, numHits);
+}
+
+TARGET_AVX2 static int FilterPlaneAVX2(const float* x, const float* y, const float* reach, int count, Plane* plane, int* hits)
+{
+	const __m256 ox = _mm256_set1_ps(plane->origin.x), oy = _mm256_set1_ps(plane->origin.y);
+	const __m256 nx = _mm256_set1_ps(plane->normal.x), ny = _mm256_set1_ps(plane->normal.y);
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(plane->oneSided ? -1 : 0x7fffffff));
+
+	int numHits = 0;
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), ox), nx),
+			_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(y + i), oy), ny));
+		int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_and_ps(d, absMask), _mm256_loadu_ps(reach + i), _CMP_LT_OQ));
+		for (int k = 0; mask; k++, mask >>= 1)
+		{
+			if (mask & 1)
+				hits[numHits++] = i + k;
+		}
+	}
+	return FilterPlaneScalar(x, y, reach, i, count, plane, hits, numHits);
+}
+
+#endif
+
+static int FilterPairs(Integrator::InstructionSet set, const float* ax, const float* ay, const float* bx, const float* by,
+	const float* reach, int count, int* hits)
+{
+#ifdef SIMD_X86
+	if (set == Integrator::AVX2)
+		return FilterPairsAVX2(ax, ay, bx, by, reach, count, hits);
+	if (set == Integrator::SSE2)
+		return FilterPairsSSE2(ax, ay, bx, by, reach, count, hits);
+#endif
+	return FilterPairsScalar(ax, ay, bx, by, reach, 0, count, hits, 0);
+}
+
+static int FilterPlane(Integrator::InstructionSet set, const float* x, const float* y, const float* reach, int count,
+	Plane* plane, int* hits)
+{
+#ifdef SIMD_X86
+	if (set == Integrator::AVX2)
+		return FilterPlaneAVX2(x, y, reach, count, plane, hits);
+	if (set == Integrator::SSE2)
+		return FilterPlaneSSE2(x, y, reach, count, plane, hits);
+#endif
+	return FilterPlaneScalar(x, y, reach, 0, count, plane, hits, 0);
+}
+
+const char* Narrowphase::BucketName(int bucket)
+{
+	static const char* names[NUM_BUCKETS] = { "circle-circle", "circle-box", "box-box", "circle-plane", "box-plane" };
+	return names[bucket];
+}
+
+Narrowphase::~Narrowphase()
+{
+	for (auto chunk : m_chunks)
+		delete chunk;
+}
+
+void Narrowphase::Run(JobSystem* jobs, Integrator::InstructionSet set, BodyStore& bodies, const std::vector<BroadphasePair>& pairs,
+	const std::vector<Plane*>& planes, std::vector<ContactManifold>& contacts)
+{
+	Clock::time_point start = Clock::now();
+
+	for (auto& bucket : m_buckets)
+		bucket.clear();
+	for (auto& pair : pairs)
+	{
+		if (pair.a->oType == PhysicsObject::BOX)
+			m_buckets[BOX_BOX].push_back(pair);
+		else if (pair.b->oType == PhysicsObject::BOX)
+			m_buckets[CIRCLE_BOX].push_back(pair);
+		else
+			m_buckets[CIRCLE_CIRCLE].push_back(pair);
+	}
+
+	m_circles.clear();
+	m_boxes.clear();
+	int count = planes.empty() ? 0 : bodies.AwakeCount();
+	for (int i = 0; i < count; i++)
+	{
+		RigidBody* body = bodies.body[i];
+		(body->oType == PhysicsObject::CIRCLE ? m_circles : m_boxes).push_back(body);
+	}
+
+	int sizes[NUM_BUCKETS] = { (int)m_buckets[CIRCLE_CIRCLE].size(), (int)m_buckets[CIRCLE_BOX].size(),
+		(int)m_buckets[BOX_BOX].size(), (int)m_circles.size(), (int)m_boxes.size() };
+	m_numChunks = 0;
+	for (int bucket = 0; bucket < NUM_BUCKETS; bucket++)
+	{
+		for (int first = 0; first < sizes[bucket]; first += CHUNK_SIZE)
+		{
+			if (m_numChunks == (int)m_chunks.size())
+				m_chunks.push_back(new Chunk());
+			Chunk& chunk = *m_chunks[m_numChunks++];
+			chunk.bucket = bucket;
+			chunk.first = first;
+			chunk.count = std::min(CHUNK_SIZE, sizes[bucket] - first);
+		}
+	}
+
+	stats = {};
+	stats.sortMs = MillisecondsSince(start);
+
+	auto job = [&](int c) { RunChunk(*m_chunks[c], set, planes); };
+	if (jobs)
+		jobs->ParallelFor(m_numChunks, job);
+	else
+	{
+		for (int c = 0; c < m_numChunks; c++)
+			job(c);
+	}
+
+	// chunks are in bucket order, so this is the same whichever threads they ran on
+	contacts.clear();
+	for (int c = 0; c < m_numChunks; c++)
+	{
+		Chunk& chunk = *m_chunks[c];
+		contacts.insert(contacts.end(), chunk.contacts.begin(), chunk.contacts.end());
+		stats.tests[chunk.bucket] += chunk.tests;
+		stats.manifolds[chunk.bucket] += (int)chunk.contacts.size();
+		stats.ms[chunk.bucket] += chunk.ms;
+	}
+
+	stats.totalMs = MillisecondsSince(start);
+}
+
+void Narrowphase::RunChunk(Chunk& chunk, Integrator::InstructionSet set, const std::vector<Plane*>& planes)
+{
+	Clock::time_point start = Clock::now();
+	chunk.contacts.clear();
+	chunk.tests = chunk.count;
+
+	switch (chunk.bucket)
+	{
+	case CIRCLE_CIRCLE:
+		CircleCircle(chunk, set);
+		break;
+	case CIRCLE_BOX:
+	case BOX_BOX:
+	{
+		Collision::CollideFunction collide = chunk.bucket == CIRCLE_BOX ?
+			Collision::Get(PhysicsObject::CIRCLE, PhysicsObject::BOX) : Collision::Get(PhysicsObject::BOX, PhysicsObject::BOX);
+		const BroadphasePair* pairs = &m_buckets[chunk.bucket][chunk.first];
+		for (int i = 0; i < chunk.count; i++)
+			collide(pairs[i].a, pairs[i].b, chunk.contacts);
+		break;
+	}
+	case CIRCLE_PLANE:
+		CirclePlane(chunk, set, planes);
+		break;
+	case BOX_PLANE:
+	{
+		chunk.tests *= (int)planes.size();
+		RigidBody* const* boxes = &m_boxes[chunk.first];
+		for (auto plane : planes)
+		{
+			for (int i = 0; i < chunk.count; i++)
+				((Box*)boxes[i])->CollideWithPlane(plane, chunk.contacts);
+		}
+		break;
+	}
+	}
+
+	chunk.ms = MillisecondsSince(start);
+}
+
+// gathers the centres of each pair into arrays, filters them, and runs the full test on the ones that might touch
+void Narrowphase::CircleCircle(Chunk& chunk, Integrator::InstructionSet set)
+{
+	float ax[CHUNK_SIZE], ay[CHUNK_SIZE], bx[CHUNK_SIZE], by[CHUNK_SIZE], reach[CHUNK_SIZE];
+	int hits[CHUNK_SIZE];
+
+	const BroadphasePair* pairs = &m_buckets[CIRCLE_CIRCLE][chunk.first];
+	for (int i = 0; i < chunk.count; i++)
+	{
+		Circle* a = (Circle*)pairs[i].a, *b = (Circle*)pairs[i].b;
+		glm::vec2 pa = a->Position(), pb = b->Position();
+		ax[i] = pa.x;
+		ay[i] = pa.y;
+		bx[i] = pb.x;
+		by[i] = pb.y;
+		reach[i] = (a->radius + b->radius) * FILTER_MARGIN;
+	}
+
+	int numHits = FilterPairs(set, ax, ay, bx, by, reach, chunk.count, hits);
+	for (int h = 0; h < numHits; h++)
+	{
+		const BroadphasePair& pair = pairs[hits[h]];
+		((Circle*)pair.b)->CollideWithCircle((Circle*)pair.a, chunk.contacts);
+	}
+}
+
+// the same for a run of circles against every plane
+void Narrowphase::CirclePlane(Chunk& chunk, Integrator::InstructionSet set, const std::vector<Plane*>& planes)
+{
+	float x[CHUNK_SIZE], y[CHUNK_SIZE], reach[CHUNK_SIZE];
+	int hits[CHUNK_SIZE];
+
+	RigidBody* const* circles = &m_circles[chunk.first];
+	for (int i = 0; i < chunk.count; i++)
+	{
+		Circle* circle = (Circle*)circles[i];
+		glm::vec2 p = circle->Position();
+		x[i] = p.x;
+		y[i] = p.y;
+		reach[i] = circle->radius * FILTER_MARGIN;
+	}
+
+	chunk.tests *= (int)planes.size();
+	for (auto plane : planes)
+	{
+		int numHits = FilterPlane(set, x, y, reach, chunk.count, plane, hits);
+		for (int h = 0; h < numHits; h++)
+			((Circle*)circles[hits[h]])->CollideWithPlane(plane, chunk.contacts);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+
+#include "Broadphase.h"
+#include "Contact.h"
+#include "Integrator.h"
+
+class BodyStore;
+class JobSystem;
+class Plane;
+
+// turns the broadphase's candidate pairs, and every awake body against every plane, into contact manifolds.
+// Pairs are sorted into a bucket for each pair of shape types and each bucket is run through its own loop, so there's
+// no lookup per pair and circles can be tested several at a time. Circle-circle and circle-plane buckets throw out
+// the pairs that can't be touching with SIMD, and only run the full test on what's left, so the manifolds come out
+// exactly as the full test alone would make them.
+class Narrowphase
+{
+public:
+	enum Bucket
+	{
+		CIRCLE_CIRCLE,
+		CIRCLE_BOX,
+		BOX_BOX,
+		CIRCLE_PLANE,
+		BOX_PLANE,
+		NUM_BUCKETS,
+	};
+
+	static const char* BucketName(int bucket);
+
+	// what the last Run() did. Times are summed over the jobs, so with more than one thread they can add up to more
+	// than the time Run() took, which is totalMs
+	struct Stats
+	{
+		int tests[NUM_BUCKETS];
+		int manifolds[NUM_BUCKETS];
+		double ms[NUM_BUCKETS];
+		// sorting the pairs into buckets and the bodies into shapes
+		double sortMs;
+		double totalMs;
+	};
+
+	~Narrowphase();
+
+	// pairs must have the lower shape type first, as Broadphase::MakePair() leaves them. Only bodies [0, AwakeCount())
+	// are tested against the planes. contacts is cleared first, and comes out in the same order however many threads there are
+	void Run(JobSystem* jobs, Integrator::InstructionSet set, BodyStore& bodies, const std::vector<BroadphasePair>& pairs,
+		const std::vector<Plane*>& planes, std::vector<ContactManifold>& contacts);
+
+	Stats stats = {};
+
+private:
+	// a run of one bucket tested as one job, with its own output so jobs don't have to share
+	struct Chunk
+	{
+		int bucket;
+		int first, count;
+		int tests;
+		double ms;
+		std::vector<ContactManifold> contacts;
+	};
+
+	void RunChunk(Chunk& chunk, Integrator::InstructionSet set, const std::vector<Plane*>& planes);
+	void CircleCircle(Chunk& chunk, Integrator::InstructionSet set);
+	void CirclePlane(Chunk& chunk, Integrator::InstructionSet set, const std::vector<Plane*>& planes);
+
+	std::vector<BroadphasePair> m_buckets[CIRCLE_PLANE];
+	std::vector<RigidBody*> m_circles;
+	std::vector<RigidBody*> m_boxes;
+	std::vector<Chunk*> m_chunks;
+	int m_numChunks = 0;
+};
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+#include <new>
+#include <utility>
+#include <vector>
+
+// refers to an object in an ObjectPool. A slot's generation goes up each time its object is destroyed,
+// so a handle to something that's gone stays invalid rather than picking up whatever reuses the slot
+struct PoolHandle
+{
+	int index = -1;
+	unsigned int generation = 0;
+};
+
+// a typed free list arena. Objects are built in place in fixed size blocks which are only freed with the pool,
+// so once it's grown to its working size creating and destroying an object is O(1) and never calls the allocator.
+// Objects don't move once created, so pointers to them stay good until they're destroyed.
+template<class T, int BLOCK_SIZE = 256>
+class ObjectPool
+{
+public:
+	ObjectPool() {}
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool& operator=(const ObjectPool&) = delete;
+
+	~ObjectPool()
+	{
+		Clear();
+		for (auto block : m_blocks)
+			::operator delete(block);
+	}
+
+	template<class... Args>
+	PoolHandle Create(Args&&... args)
+	{
+		if (m_free.empty())
+			Grow();
+
+		int index = m_free.back();
+		m_free.pop_back();
+		new (Slot(index)) T(std::forward<Args>(args)...);
+		m_live[index] = true;
+		m_count++;
+		return { index, m_generations[index] };
+	}
+
+	void Destroy(PoolHandle h)
+	{
+		if (!IsValid(h))
+			return;
+
+		Slot(h.index)->~T();
+		m_live[h.index] = false;
+		m_generations[h.index]++;
+		m_free.push_back(h.index);
+		m_count--;
+	}
+
+	// destroys everything, keeping the memory for reuse
+	void Clear()
+	{
+		for (int i = 0; i < Capacity(); i++)
+		{
+			if (m_live[i])
+				Destroy({ i, m_generations[i] });
+		}
+	}
+
+	bool IsValid(PoolHandle h) { return h.index >= 0 && h.index < Capacity() && m_live[h.index] && m_generations[h.index] == h.generation; }
+	// null if the handle's object has been destroyed
+	T* Get(PoolHandle h) { return IsValid(h) ? Slot(h.index) : nullptr; }
+
+	int Count() { return m_count; }
+	int Capacity() { return (int)m_live.size(); }
+
+	// calls f(object) for every live object, in slot order
+	template<class F>
+	void ForEach(F f)
+	{
+		for (int i = 0; i < Capacity(); i++)
+		{
+			if (m_live[i])
+				f(*Slot(i));
+		}
+	}
+
+private:
+	T* Slot(int index) { return (T*)m_blocks[index / BLOCK_SIZE] + index % BLOCK_SIZE; }
+
+	void Grow()
+	{
+		int first = Capacity();
+		m_blocks.push_back(::operator new(sizeof(T) * BLOCK_SIZE));
+		m_live.resize(first + BLOCK_SIZE, false);
+		m_generations.resize(first + BLOCK_SIZE, 0);
+
+		// lowest slots on top of the free list, so they get used first
+		for (int i = BLOCK_SIZE - 1; i >= 0; i--)
+			m_free.push_back(first + i);
+	}
+
+	std::vector<void*> m_blocks;
+	std::vector<bool> m_live;
+	std::vector<unsigned int> m_generations;
+	std::vector<int> m_free;
+	int m_count = 0;
+};
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include <glm/glm/glm.hpp>
+#include <math.h>
+
+#include "ParticleSystem.h"
+#include "Plane.h"
+#include "Box.h"
+#include "DebugDraw.h"
+#include "Simd.h"
+
+
+// how long the streak drawn for each particle is, in seconds of travel
+static const float STREAK_TIME = 1.0f / 60.0f;
+// bounced particles are left this far off the surface, on the side they came from. Leaving them exactly on it
+// lets rounding put them a hair the wrong side, and they'd fall through next time
+static const float SURFACE_OFFSET = 1e-3f;
+
+void ParticleSystem::Emit(glm::vec2 position, glm::vec2 velocity, float lifeTime)
+{
+	x.push_back(position.x);
+	y.push_back(position.y);
+	vx.push_back(velocity.x);
+	vy.push_back(velocity.y);
+	life.push_back(lifeTime);
+}
+
+void ParticleSystem::Clear()
+{
+	x.clear();
+	y.clear();
+	vx.clear();
+	vy.clear();
+	life.clear();
+}
+
+// one particle, used for the whole range by the scalar path and for the left overs by the other. A particle has hit
+// a plane if it's crossed it this step, from either side. It's put back by the plane, with its speed into the plane
+// reversed and scaled by the restitution
+static void StepParticle(ParticleSystem& p, int i, float dt, glm::vec2 gravityDt, const ParticleSystem::Surface* planes, int numPlanes, float bounce)
+{
+	float x0 = p.x[i], y0 = p.y[i];
+	p.vx[i] += gravityDt.x;
+	p.vy[i] += gravityDt.y;
+	p.x[i] += p.vx[i] * dt;
+	p.y[i] += p.vy[i] * dt;
+	p.life[i] -= dt;
+
+	for (int k = 0; k < numPlanes; k++)
+	{
+		glm::vec2 origin = planes[k].origin, normal = planes[k].normal;
+		float d0 = (x0 - origin.x) * normal.x + (y0 - origin.y) * normal.y;
+		float d = (p.x[i] - origin.x) * normal.x + (p.y[i] - origin.y) * normal.y;
+		if ((d0 >= 0) != (d >= 0))
+		{
+			float vn = p.vx[i] * normal.x + p.vy[i] * normal.y;
+			d -= d0 >= 0 ? SURFACE_OFFSET : -SURFACE_OFFSET;
+			p.x[i] -= d * normal.x;
+			p.y[i] -= d * normal.y;
+			p.vx[i] -= bounce * vn * normal.x;
+			p.vy[i] -= bounce * vn * normal.y;
+		}
+	}
+}
+
+#ifdef SIMD_X86
+
+// four particles at a time
+TARGET_SSE2 static void StepSSE2(ParticleSystem& p, int count, float dt, glm::vec2 gravityDt, const ParticleSystem::Surface* planes, int numPlanes, float bounce)
+{
+	const __m128 vdt = _mm_set1_ps(dt);
+	const __m128 gx = _mm_set1_ps(gravityDt.x), gy = _mm_set1_ps(gravityDt.y);
+	const __m128 b = _mm_set1_ps(bounce);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 offset = _mm_set1_ps(SURFACE_OFFSET);
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x0 = _mm_loadu_ps(&p.x[i]), y0 = _mm_loadu_ps(&p.y[i]);
+		__m128 vx = _mm_add_ps(_mm_loadu_ps(&p.vx[i]), gx);
+		__m128 vy = _mm_add_ps(_mm_loadu_ps(&p.vy[i]), gy);
+		__m128 x = _mm_add_ps(x0, _mm_mul_ps(vx, vdt));
+		__m128 y = _mm_add_ps(y0, _mm_mul_ps(vy, vdt));
+		_mm_storeu_ps(&p.life[i], _mm_sub_ps(_mm_loadu_ps(&p.life[i]), vdt));
+
+		for (int k = 0; k < numPlanes; k++)
+		{
+			__m128 nx = _mm_set1_ps(planes[k].normal.x), ny = _mm_set1_ps(planes[k].normal.y);
+			__m128 ox = _mm_set1_ps(planes[k].origin.x), oy = _mm_set1_ps(planes[k].origin.y);
+			__m128 d0 = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(x0, ox), nx), _mm_mul_ps(_mm_sub_ps(y0, oy), ny));
+			__m128 d = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(x, ox), nx), _mm_mul_ps(_mm_sub_ps(y, oy), ny));
+			__m128 above = _mm_cmpge_ps(d0, zero);
+			__m128 crossed = _mm_xor_ps(above, _mm_cmpge_ps(d, zero));
+			if (!_mm_movemask_ps(crossed))
+				continue;
+
+			// only the crossed lanes move
+			__m128 vn = _mm_add_ps(_mm_mul_ps(vx, nx), _mm_mul_ps(vy, ny));
+			d = _mm_sub_ps(d, _mm_or_ps(offset, _mm_andnot_ps(above, signMask)));
+			d = _mm_and_ps(crossed, d);
+			vn = _mm_and_ps(crossed, _mm_mul_ps(b, vn));
+			x = _mm_sub_ps(x, _mm_mul_ps(d, nx));
+			y = _mm_sub_ps(y, _mm_mul_ps(d, ny));
+			vx = _mm_sub_ps(vx, _mm_mul_ps(vn, nx));
+			vy = _mm_sub_ps(vy, _mm_mul_ps(vn, ny));
+		}
+
+		_mm_storeu_ps(&p.x[i], x);
+		_mm_storeu_ps(&p.y[i], y);
+		_mm_storeu_ps(&p.vx[i], vx);
+		_mm_storeu_ps(&p.vy[i], vy);
+	}
+
+	for (; i < count; i++)
+		StepParticle(p, i, dt, gravityDt, planes, numPlanes, bounce);
+}
+
+#endif
+
+void ParticleSystem::Update(Integrator::InstructionSet set, float dt, glm::vec2 gravity, const std::vector<Plane*>& planes, const std::vector<Box*>& boxes)
+{
+	int count = Count();
+	if (count == 0)
+		return;
+
+	m_planes.clear();
+	for (int k = 0; collide && k < (int)planes.size(); k++)
+		m_planes.push_back({ planes[k]->origin, planes[k]->normal });
+
+	glm::vec2 gravityDt = gravity * dt;
+	float bounce = 1 + restitution;
+
+#ifdef SIMD_X86
+	// there's nothing here that gains from AVX2, so it takes the SSE2 path too
+	if (set != Integrator::SCALAR)
+		StepSSE2(*this, count, dt, gravityDt, m_planes.data(), (int)m_planes.size(), bounce);
+	else
+#endif
+	{
+		for (int i = 0; i < count; i++)
+			StepParticle(*this, i, dt, gravityDt, m_planes.data(), (int)m_planes.size(), bounce);
+	}
+
+	for (int k = 0; collide && k < (int)boxes.size(); k++)
+		CollideWithBox(boxes[k]);
+
+	RemoveDead();
+}
+
+// boxes are few and far between compared to planes, so this rejects on the box's bounds and does the rest one at a time.
+// A particle inside the box is pushed out through the nearest side and bounced off it
+void ParticleSystem::CollideWithBox(Box* box)
+{
+	AABB bounds = box->GetAABB();
+	glm::vec2 centre = box->Position(), localX = box->LocalX(), localY = box->LocalY();
+	float halfWidth = box->width / 2, halfHeight = box->height / 2;
+	float bounce = 1 + restitution;
+
+	int count = Count();
+	for (int i = 0; i < count; i++)
+	{
+		if (x[i] < bounds.min.x || x[i] > bounds.max.x || y[i] < bounds.min.y || y[i] > bounds.max.y)
+			continue;
+
+		glm::vec2 offset(x[i] - centre.x, y[i] - centre.y);
+		float lx = glm::dot(offset, localX), ly = glm::dot(offset, localY);
+		float penX = halfWidth - fabsf(lx), penY = halfHeight - fabsf(ly);
+		if (penX <= 0 || penY <= 0)
+			continue;
+
+		glm::vec2 normal = penX < penY ? (lx < 0 ? -localX : localX) : (ly < 0 ? -localY : localY);
+		float pen = glm::min(penX, penY);
+		x[i] += normal.x * pen;
+		y[i] += normal.y * pen;
+
+		float vn = vx[i] * normal.x + vy[i] * normal.y;
+		if (vn < 0)
+		{
+			vx[i] -= bounce * vn * normal.x;
+			vy[i] -= bounce * vn * normal.y;
+		}
+	}
+}
+
+// compacts the arrays, keeping the live particles in order
+void ParticleSystem::RemoveDead()
+{
+	int count = Count(), live = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (life[i] <= 0)
+			continue;
+		x[live] = x[i];
+		y[live] = y[i];
+		vx[live] = vx[i];
+		vy[live] = vy[i];
+		life[live] = life[i];
+		live++;
+	}
+
+	x.resize(live);
+	y.resize(live);
+	vx.resize(live);
+	vy.resize(live);
+	life.resize(live);
+}
+
+void ParticleSystem::Draw(DebugDraw* draw)
+{
+	int count = Count();
+	m_lines.resize(count * 2);
+	for (int i = 0; i < count; i++)
+	{
+		m_lines[2 * i] = glm::vec2(x[i], y[i]);
+		m_lines[2 * i + 1] = glm::vec2(x[i] - vx[i] * STREAK_TIME, y[i] - vy[i] * STREAK_TIME);
+	}
+	draw->add2DLines(m_lines.data(), count, colour);
+}
\ No newline at end of file
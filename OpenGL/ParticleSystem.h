@@ -0,0 +1,54 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+#include <vector>
+
+#include "Integrator.h"
+
+class Plane;
+class Box;
+class DebugDraw;
+
+// lightweight particles for exhaust, sparks and debris. They aren't rigid bodies: they have no size or mass, stay
+// out of the broadphase, and bounce off planes and fixed boxes without pushing back on them. Each coordinate is its
+// own array, so the update streams straight through them several particles at a time.
+class ParticleSystem
+{
+public:
+	// adds a particle that lives for life seconds
+	void Emit(glm::vec2 position, glm::vec2 velocity, float life);
+	void Clear();
+
+	int Count() { return (int)x.size(); }
+
+	// moves every particle on by dt, bounces them off the planes and boxes, then removes those that have run out of life
+	void Update(Integrator::InstructionSet set, float dt, glm::vec2 gravity, const std::vector<Plane*>& planes, const std::vector<Box*>& boxes);
+
+	// all the particles as short streaks along their velocity, in one batch
+	void Draw(DebugDraw* draw);
+
+	// whether particles bounce off anything at all
+	bool collide = true;
+	// how much of the speed into a surface is kept on a bounce
+	float restitution = 0.3f;
+	glm::vec4 colour = glm::vec4(1, 0.6f, 0.1f, 1);
+
+	std::vector<float> x, y;
+	std::vector<float> vx, vy;
+	// seconds left to live
+	std::vector<float> life;
+
+	// a plane, copied out so the update doesn't have to chase pointers
+	struct Surface
+	{
+		glm::vec2 origin;
+		glm::vec2 normal;
+	};
+
+private:
+	void CollideWithBox(Box* box);
+	void RemoveDead();
+
+	std::vector<Surface> m_planes;
+	// scratch space for Draw()
+	std::vector<glm::vec2> m_lines;
+};
\ No newline at end of file
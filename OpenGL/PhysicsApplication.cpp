@@ -1,13 +1,18 @@
 #include <glm\glm\ext.hpp>
 #include "PhysicsApplication.h"
+#include "RigidBody.h"
 #include "Circle.h"
-#include "Plane.h"
-#include "Box.h"
-#include "Spring.h"
-#include "LunarLander.h"
+#include "Scenes.h"
+#include "SceneFile.h"
 
 using namespace glm;
 
+// the scene P resets to, and that recordings start from. A scene file (see SceneFile), or the name of one of the
+// scenes built in code: pool, lander, springs, basic or twoboxes
+static const char* SCENE = "scenes/twoboxes.scene";
+static const char* REPLAY_PATH = "physics_replay.bin";
+static const char* SNAPSHOT_PATH = "physics_snapshot.bin";
+
 PhysicsApplication* PhysicsApplication::theApp = NULL;
 bool PhysicsApplication::singleStep = false;
 
@@ -23,6 +28,8 @@ bool PhysicsApplication::startup()
 		return false;
 	}
 	glfwMakeContextCurrent(window);
+	// the world steps itself by the time that's passed, so just let vsync pace the frames
+	glfwSwapInterval(1);
 
 	if (ogl_LoadFunctions() == ogl_LOAD_FAILED) {
 		glfwDestroyWindow(window);
@@ -40,15 +47,22 @@ bool PhysicsApplication::startup()
 
 	Gizmos::create(65335U, 65535U, 65535U, 65535U);
 
+	world.debugDraw = &gizmoDraw;
+	// energies and counts go to a file from a background thread, rather than the console every frame
+	if (!world.telemetry.Start("telemetry.csv", Telemetry::CSV))
+		printf("couldn't open telemetry.csv\n");
+
 	Reset();
 
 	camera.radius = 1;
+	m_lastTime = glfwGetTime();
 
 	return true;
 }
 
 void PhysicsApplication::shutdown()
 {
+	world.telemetry.Stop();
 	Gizmos::destroy();
 
 	glfwDestroyWindow(window);
@@ -65,49 +79,28 @@ bool PhysicsApplication::update()
 
 	camera.update(window);
 
-	float energy = 0;
-	float g0=0, k0=0, r0 = 0, g, k, r;
-
 	if (glfwGetKey(window, GLFW_KEY_O))
 		singleStep = false;
 
+	world.input = 0;
+	if (glfwGetKey(window, GLFW_KEY_Z))
+		world.input |= PhysicsWorld::INPUT_THRUST_LEFT;
+	if (glfwGetKey(window, GLFW_KEY_C))
+		world.input |= PhysicsWorld::INPUT_THRUST_RIGHT;
+
+	// step by however long the last frame took, in fixed steps
+	double time = glfwGetTime();
+	float elapsed = (float)(time - m_lastTime);
+	m_lastTime = time;
+
 	if (!singleStep)
 	{
-		for (auto it = m_physicsObjects.begin(); it != m_physicsObjects.end(); it++)
-		{
-			PhysicsObject* obj = *it;
+		world.Advance(elapsed);
 
-			if (obj->lifeSpan > 0)
-			{
-				obj->lifeSpan--;
-				if (obj->lifeSpan == 0)
-				{
-					delete obj;
-					m_physicsObjects.erase(it++);
-					continue;
-				}
-			}
-			obj->Update(dt);
-
-			// accumulate all energy components
-			energy += obj->getEnergy(k, g, r);
-			k0 += k; g0 += g; r0 += r;
-
-			// collisions - check this object with everything further up the list
-			for (auto it2 = it; it2 != m_physicsObjects.end(); it2++)
-			{
-				if (it != it2)
-				{
-					PhysicsObject* obj2 = *it2;
-					obj2->CheckCollisions(obj);
-
-				}
-			}
-		}
+		// pause as soon as anything collides, press O to carry on
+		if (world.numContacts > 0)
+			singleStep = true;
 	}
-	
-	printf("%10.3f + %10.3f + %10.3f = %10.3f\n", k0, r0, g0, k0+r0+g0);
-	Sleep(1000*dt);
 
 	// check for mousedown
 	bool mouseDown = glfwGetMouseButton(window, 0);
@@ -132,16 +125,10 @@ bool PhysicsApplication::update()
 		else
 		{
 			//m_physicsObjects.push_back(new Box(m_mousePoint, vec2(0, 0), 1, 0, 0.5f, 0.5f));
-			for (auto it = m_physicsObjects.begin(); it != m_physicsObjects.end(); it++)
-			{
-				PhysicsObject* obj = *it;
-				if (obj->IsInside(m_mousePoint))
-				{
-					// must be a RigidBody, so we can safely cast!
-					RigidBody* rb = (RigidBody*)obj;
-					rb->ApplyForce(2.0f*(m_mousePoint - m_contactPoint), m_contactPoint);
-				}
-			}
+			std::vector<RigidBody*> picked;
+			world.QueryPoint(m_mousePoint, picked);
+			for (auto rb : picked)
+				world.ApplyForce(rb, 2.0f*(m_mousePoint - m_contactPoint), m_contactPoint);
 		}
 		m_mouseDown = mouseDown;
 	}
@@ -149,6 +136,75 @@ bool PhysicsApplication::update()
 	if (glfwGetKey(window, GLFW_KEY_P))
 		Reset();
 
+	// R resets the scene and records from there until it's pressed again, then saves the recording to play back
+	// headless with physics_bench -replay
+	bool recordKeyDown = glfwGetKey(window, GLFW_KEY_R) != 0;
+	if (recordKeyDown && !m_recordKeyDown)
+	{
+		if (!world.recording)
+		{
+			Reset();
+			m_replay.Start(world, SCENE);
+			printf("recording\n");
+		}
+		else
+		{
+			m_replay.Stop(world);
+			if (m_replay.Save(REPLAY_PATH))
+				printf("%d steps recorded to %s\n", m_replay.NumSteps(), REPLAY_PATH);
+		}
+	}
+	m_recordKeyDown = recordKeyDown;
+
+	// B cycles through the broadphase types so they can be compared on the same scene
+	bool broadphaseKeyDown = glfwGetKey(window, GLFW_KEY_B) != 0;
+	if (broadphaseKeyDown && !m_broadphaseKeyDown)
+	{
+		static const char* names[] = { "brute force", "spatial hash", "sweep and prune", "aabb tree" };
+		int type = (world.m_broadphase->GetType() + 1) % 4;
+		world.SetBroadphase((Broadphase::BroadphaseType)type);
+		printf("broadphase: %s\n", names[type]);
+	}
+	m_broadphaseKeyDown = broadphaseKeyDown;
+
+	// I prints how long each phase has been taking, T starts a trace and then writes it out when pressed again
+	bool profileKeyDown = glfwGetKey(window, GLFW_KEY_I) != 0;
+	if (profileKeyDown && !m_profileKeyDown)
+		world.profiler.Print();
+	m_profileKeyDown = profileKeyDown;
+
+	bool traceKeyDown = glfwGetKey(window, GLFW_KEY_T) != 0;
+	if (traceKeyDown && !m_traceKeyDown)
+	{
+		if (!world.profiler.IsTracing())
+			world.profiler.StartTrace();
+		else if (world.profiler.WriteTrace("physics_trace.json"))
+			printf("trace written to physics_trace.json\n");
+	}
+	m_traceKeyDown = traceKeyDown;
+
+	// F5 takes a snapshot of the world, and saves it too, and F9 rolls back to it. A snapshot saved on a
+	// previous run is loaded if there's none yet
+	bool saveKeyDown = glfwGetKey(window, GLFW_KEY_F5) != 0;
+	if (saveKeyDown && !m_saveKeyDown)
+	{
+		m_snapshot.Capture(world);
+		if (m_snapshot.Save(SNAPSHOT_PATH))
+			printf("snapshot saved to %s\n", SNAPSHOT_PATH);
+	}
+	m_saveKeyDown = saveKeyDown;
+
+	bool restoreKeyDown = glfwGetKey(window, GLFW_KEY_F9) != 0;
+	if (restoreKeyDown && !m_restoreKeyDown)
+	{
+		// a recording can't play a jump back
+		if (world.recording)
+			printf("stop recording before restoring a snapshot\n");
+		else if ((m_snapshot.Size() > 0 || m_snapshot.Load(SNAPSHOT_PATH)) && m_snapshot.Restore(world))
+			printf("snapshot restored\n");
+	}
+	m_restoreKeyDown = restoreKeyDown;
+
 	return (glfwWindowShouldClose(window) == false && glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS);
 }
 
@@ -168,11 +224,15 @@ void PhysicsApplication::draw()
 		Gizmos::add2DLine(vec2(10, -10 + i), vec2(-10, -10 + i), i == 10 ? orange : white);
 	}
 
-	// add a gizmo for every object in the scene
-	for (auto it = m_physicsObjects.begin(); it != m_physicsObjects.end(); it++)
+	// add a gizmo for every object in the scene, particles first so they're underneath
 	{
-		PhysicsObject* obj = *it;
-		obj->Draw();
+		PROFILE_SCOPE(world.profiler, Profiler::DRAW);
+		world.particleSystem.Draw(&gizmoDraw);
+		for (auto it = world.m_physicsObjects.begin(); it != world.m_physicsObjects.end(); it++)
+		{
+			PhysicsObject* obj = *it;
+			obj->Draw(&gizmoDraw);
+		}
 	}
 
 	if (m_mouseDown)
@@ -185,111 +245,19 @@ void PhysicsApplication::draw()
 	glfwPollEvents();
 
 	day++;
+	world.profiler.EndFrame();
 }
 
 void PhysicsApplication::Reset()
 {
-	m_physicsObjects.clear();
-	//ResetPool();
-	//ResetLunarLander();
-	//ResetSprings();
-	//ResetBasic();
-	ResetTwoBoxes();
-}
-
-void PhysicsApplication::ResetPool()
-{
-	RigidBody::gravity.y = 0;
-	m_physicsObjects.push_back(new Box(vec2(-10, 0), vec2(0, 0), 0, 1.0f, 10.0f, 10, true));
-	m_physicsObjects.push_back(new Box(vec2(10, 0), vec2(0, 0), 0, 1.0f, 10.0f, 10, true));
-	m_physicsObjects.push_back(new Box(vec2(-5, 7), vec2(0, 0), 0, 8.0f, 1.0f, 10, true));
-	m_physicsObjects.push_back(new Box(vec2(5, 7), vec2(0, 0), 0, 8.0f, 1.0f, 10, true));
-	m_physicsObjects.push_back(new Box(vec2(-5, -7), vec2(0, 0), 0, 8.0f, 1.0f, 10, true));
-	m_physicsObjects.push_back(new Box(vec2(5, -7), vec2(0, 0), 0, 8.0f, 1.0f, 10, true));
-
-	m_physicsObjects.push_back(new Circle(vec2(-5, 0), vec2(0, 0), 0.5f));
-
-	m_physicsObjects.push_back(new Circle(vec2(5, 0), vec2(0, 0), 0.5f));
-	m_physicsObjects.push_back(new Circle(vec2(6, 1), vec2(0, 0), 0.5f));
-	m_physicsObjects.push_back(new Circle(vec2(6, -1), vec2(0, 0), 0.5f));
-}
-
-void PhysicsApplication::ResetLunarLander()
-{
-	RigidBody::gravity.y = -9;
-	m_physicsObjects.push_back(new LunarLander(vec2(0, 0)));
-
-	m_physicsObjects.push_back(new Plane(vec2(0, -5), vec2(0, 1)));
-}
-
-void PhysicsApplication::ResetSprings()
-{
-	Circle* c[25];
-	for (int x = 0; x < 5; x++)
-	{
-		for (int y = 0; y < 5; y++)
-		{
-			Circle* c0 = new Circle(vec2(x * 2 - 5, y * 2), vec2(0, 0), 1.0f);
-			c[x + y * 5] = c0;
-			m_physicsObjects.push_back(c0);
-			if (x > 0)
-				m_physicsObjects.push_back(new Spring(c0, c[(x - 1) + y * 5], 2.0f, 150.0f, vec2(-0.5, 0), vec2(0.5, 0)));
-			if (y > 0)
-				m_physicsObjects.push_back(new Spring(c0, c[x + (y - 1) * 5], 2.0f, 150.0f, vec2(0, -0.5), vec2(0, 0.5)));
-		}
-	}
-
-	m_physicsObjects.push_back(new Plane(vec2(0, -5), vec2(0, 1)));
-	m_physicsObjects.push_back(new Plane(vec2(-7.1f, 0.0f), vec2(0.707f, 0.707f)));
-	m_physicsObjects.push_back(new Plane(vec2(7.1f, 0.0f), vec2(-1, 0)));
-}
-
-void PhysicsApplication::ResetBasic()
-{
-	Circle* c1 = new Circle(vec2(0, 5), vec2(-1, 0), 2.0f);
-	Circle* c2 = new Circle(vec2(2, 5), vec2(1, 0), 1.0f);
-	Circle* c3 = new Circle(vec2(-2, 5), vec2(2, 0), 0.5f, 100.0f);
-	m_physicsObjects.push_back(c1);
-	m_physicsObjects.push_back(c2);
-	m_physicsObjects.push_back(c3);
-	m_physicsObjects.push_back(new Spring(c1, c2, 6, 10));
-	m_physicsObjects.push_back(new Spring(c2, c3, 6, 10));
-	m_physicsObjects.push_back(new Spring(c1, c3, 6, 10));
-
-	m_physicsObjects.push_back(new Circle(vec2(0, 8), vec2(0.5f, 0), 0.5f));
-	m_physicsObjects.push_back(new Circle(vec2(0, 10), vec2(-0.5f, 0), 0.5f));
-	m_physicsObjects.push_back(new Circle(vec2(0, 12), vec2(0.5f, 0), 0.5f));
-
-	m_physicsObjects.push_back(new Box(vec2(-1, -4), vec2(0, 0), 0, 0.5f, 2.0f));
-	m_physicsObjects.push_back(new Box(vec2(1, -4), vec2(0, 0), 0, 0.5f, 2.0f));
-	m_physicsObjects.push_back(new Box(vec2(0, -2.75f), vec2(0, 0), 0.05f, 3.0f, 0.5f));
-
-	m_physicsObjects.push_back(new Box(vec2(0, 20), vec2(0, 0), 0, 1.0f, 3.0f));
-
-	m_physicsObjects.push_back(new Circle(vec2(0, 22), vec2(0.5f, 0), 2.0f));
-
-	m_physicsObjects.push_back(new Box(vec2(0, 4), vec2(0, 0), 0, 1.0f, 3.0f));
-
-	m_physicsObjects.push_back(new Plane(vec2(0, -5), vec2(0, 1)));
-	m_physicsObjects.push_back(new Plane(vec2(-7.1f, 0.0f), vec2(0.707f, 0.707f)));
-	m_physicsObjects.push_back(new Plane(vec2(7.1f, 0.0f), vec2(-1, 0)));
-}
-
-void PhysicsApplication::ResetTwoBoxes()
-{
-	static float angle1 = 0;
-	static float angle2 = 0;
-
-	RigidBody::gravity.y = -9;
-	//m_physicsObjects.push_back(new Box(vec2(0, 1.5f), vec2(0, 0), 0, 0.5f, 0.5f, 10));
-	//m_physicsObjects.push_back(new Box(vec2(0, -0.5), vec2(0, 0), 0, 0.5f, 0.5f, 10));
-	m_physicsObjects.push_back(new Box(vec2(1, 5), vec2(0, 0), angle1 * 3.1415f/180.0f, 3.0f, 1.0f));
-	m_physicsObjects.push_back(new Box(vec2(0, 9), vec2(0, 0), angle2 * 3.1415f/180.0f, 3.0f, 1.0f));
-	//m_physicsObjects.push_back(new Box(vec2(-4, 11), vec2(0, 0), -45, 3.0f, 1.0f));
-
-	//m_physicsObjects.push_back(new Circle(vec2(0, 22), vec2(0.5f, 0), 2.0f, 0.1f));
-
-	m_physicsObjects.push_back(new Plane(vec2(0, -5), vec2(0, 1)));
-	m_physicsObjects.push_back(new Plane(vec2(-7.1f, 0.0f), vec2(0.707f, 0.707f)));
-	m_physicsObjects.push_back(new Plane(vec2(7.1f, 0.0f), vec2(-1, 0)));
+	// a recording can't carry on through a reset
+	if (world.recording)
+		m_replay.Stop(world);
+
+	world.Clear();
+	SceneFile scene;
+	if (SceneFunction reset = FindScene(SCENE))
+		reset(&world);
+	else if (!scene.Load(world, SCENE))
+		printf("couldn't load %s: %s\n", SCENE, scene.Error());
 }
\ No newline at end of file
@@ -11,7 +11,24 @@
 #include "Application.h"
 #include "Camera.h"
 #include "Model.h"
-#include "PhysicsObject.h"
+#include "PhysicsWorld.h"
+#include "DebugDraw.h"
+#include "Replay.h"
+#include "Snapshot.h"
+
+// implements the physics debug drawing interface with Gizmos
+class GizmoDraw : public DebugDraw
+{
+public:
+	virtual void add2DLine(glm::vec2 start, glm::vec2 end, glm::vec4 colour) { Gizmos::add2DLine(start, end, colour); }
+	virtual void add2DTri(glm::vec2 p1, glm::vec2 p2, glm::vec2 p3, glm::vec4 colour) { Gizmos::add2DTri(p1, p2, p3, colour); }
+	virtual void add2DCircle(glm::vec2 centre, float radius, int segments, glm::vec4 colour) { Gizmos::add2DCircle(centre, radius, segments, colour); }
+	virtual void add2DLines(const glm::vec2* points, int count, glm::vec4 colour)
+	{
+		for (int i = 0; i < count; i++)
+			Gizmos::add2DLine(points[2 * i], points[2 * i + 1], colour);
+	}
+};
 
 class PhysicsApplication : public Application
 {
@@ -25,11 +42,6 @@ public:
 	virtual void draw();
 
 	void Reset();
-	void ResetPool();
-	void ResetLunarLander();
-	void ResetSprings();
-	void ResetBasic();
-	void ResetTwoBoxes();
 
 	int day = 0;
 
@@ -38,13 +50,21 @@ public:
 
 	GLuint shaderID;
 
-	float dt = 1.0f / 60.0f;
-
-	std::list<PhysicsObject*> m_physicsObjects;
+	PhysicsWorld world;
+	GizmoDraw gizmoDraw;
 
 	glm::vec2 m_contactPoint;
 	glm::vec2 m_mousePoint;
 	bool m_mouseDown;
+	bool m_broadphaseKeyDown = false;
+	bool m_profileKeyDown = false;
+	bool m_traceKeyDown = false;
+	bool m_recordKeyDown = false;
+	bool m_saveKeyDown = false;
+	bool m_restoreKeyDown = false;
+	Replay m_replay;
+	Snapshot m_snapshot;
+	double m_lastTime = 0;
 
 	static bool singleStep;
 };
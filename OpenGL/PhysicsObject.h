@@ -1,8 +1,14 @@
 #pragma once
+#include <vector>
+
+#include "Contact.h"
+#include "ObjectPool.h"
 
 class Plane;
 class Circle;
 class Box;
+class DebugDraw;
+class PhysicsWorld;
 
 class PhysicsObject
 {
@@ -16,17 +22,12 @@ public:
 	};
 
 	PhysicsObject() : color(1, 0, 0, 1) {}
+	virtual ~PhysicsObject() {}
 
 	virtual void Update(float dt) = 0;
-	virtual void Draw() = 0;
-
-	virtual void CheckCollisions(PhysicsObject * other);
-
-	virtual void CollideWithPlane(Plane* plane) = 0;
-	virtual void CollideWithCircle(Circle* circle) = 0;
-	virtual void CollideWithBox(Box* circle) = 0;
-
-	virtual float getEnergy(float& k, float& g, float &r) { k = 0; r = 0; g = 0; return 0; }
+	// false if Update() does nothing, so the world can skip calling it
+	virtual bool HasUpdate() { return true; }
+	virtual void Draw(DebugDraw* draw) = 0;
 
 	virtual bool IsInside(glm::vec2 pt) { return false; }
 
@@ -34,4 +35,10 @@ public:
 	glm::vec4 color;
 
 	int lifeSpan = 0;
+
+	// the world this object has been added to
+	PhysicsWorld* world = nullptr;
+	// where the object is in one of its world's pools, if it was made with PhysicsWorld::NewCircle() or the like
+	// rather than new
+	PoolHandle pool;
 };
\ No newline at end of file
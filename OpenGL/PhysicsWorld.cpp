@@ -0,0 +1,801 @@
+#include <glm/glm/glm.hpp>
+#include <algorithm>
+#include <math.h>
+
+#include "PhysicsWorld.h"
+#include "RigidBody.h"
+#include "Plane.h"
+#include "Spring.h"
+#include "Circle.h"
+#include "Box.h"
+#include "JobSystem.h"
+#include "Replay.h"
+#include "Snapshot.h"
+
+// rough amount of work worth handing to another thread in one go
+static const int ISLAND_BATCH_COST = 256;
+
+static bool IsRigidBody(PhysicsObject* obj)
+{
+	return obj->oType == PhysicsObject::CIRCLE || obj->oType == PhysicsObject::BOX;
+}
+
+static int FindRoot(std::vector<int>& parent, int i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+// merges the sets holding a and b. The lowest body index is always the root, which keeps island numbering deterministic.
+static void Join(std::vector<int>& parent, int a, int b)
+{
+	a = FindRoot(parent, a);
+	b = FindRoot(parent, b);
+	if (a < b)
+		parent[b] = a;
+	else if (b < a)
+		parent[a] = b;
+}
+
+PhysicsWorld::~PhysicsWorld()
+{
+	Clear();
+	delete m_broadphase;
+	delete m_jobs;
+	for (auto batch : m_solvers)
+		delete batch;
+}
+
+void PhysicsWorld::AddObject(PhysicsObject* obj, bool atFront)
+{
+	obj->world = this;
+	if (atFront)
+		m_physicsObjects.insert(m_physicsObjects.begin(), obj);
+	else
+		m_physicsObjects.push_back(obj);
+
+	if (IsRigidBody(obj))
+	{
+		// bodies restored from a snapshot are already in the store
+		if (!((RigidBody*)obj)->store)
+			((RigidBody*)obj)->Attach(&bodies);
+		m_broadphase->AddBody((RigidBody*)obj);
+		if (obj->oType == PhysicsObject::BOX && ((Box*)obj)->IsFixed())
+			m_fixedBoxes.push_back((Box*)obj);
+	}
+	else if (obj->oType == PhysicsObject::PLANE)
+	{
+		m_planes.push_back((Plane*)obj);
+	}
+
+	if (obj->HasUpdate())
+		m_updateObjects.push_back(obj);
+	if (obj->lifeSpan > 0)
+		AddExpiry(obj, obj->lifeSpan);
+}
+
+Circle* PhysicsWorld::NewCircle(glm::vec2 position, glm::vec2 velocity, float radius, float density)
+{
+	PoolHandle handle = circlePool.Create(position, velocity, radius, 0.0f, density);
+	Circle* circle = circlePool.Get(handle);
+	circle->pool = handle;
+	return circle;
+}
+
+Box* PhysicsWorld::NewBox(glm::vec2 position, glm::vec2 velocity, float angle, float width, float height, float density, bool fixed)
+{
+	PoolHandle handle = boxPool.Create(position, velocity, angle, width, height, density, fixed);
+	Box* box = boxPool.Get(handle);
+	box->pool = handle;
+	return box;
+}
+
+Spring* PhysicsWorld::NewSpring(RigidBody* body1, RigidBody* body2, float restLength, float restoringForce, glm::vec2 contact1, glm::vec2 contact2)
+{
+	PoolHandle handle = springPool.Create(body1, body2, restLength, restoringForce, contact1, contact2);
+	Spring* spring = springPool.Get(handle);
+	spring->pool = handle;
+	return spring;
+}
+
+void PhysicsWorld::AddExpiry(PhysicsObject* obj, int lifeSpan)
+{
+	// make sure the wheel is big enough that this won't come round again before it expires
+	int size = (int)m_expiryWheel.size();
+	if (lifeSpan >= size)
+	{
+		int newSize = std::max(size, 64);
+		while (newSize <= lifeSpan)
+			newSize *= 2;
+
+		std::vector<std::vector<Expiry>> wheel(newSize);
+		for (auto& bucket : m_expiryWheel)
+		{
+			for (auto& expiry : bucket)
+				wheel[expiry.step & (newSize - 1)].push_back(expiry);
+		}
+		m_expiryWheel.swap(wheel);
+	}
+
+	int step = m_stepCount + lifeSpan;
+	m_expiryWheel[step & (m_expiryWheel.size() - 1)].push_back({ step, obj });
+	m_numTransient++;
+}
+
+void PhysicsWorld::RemoveObject(PhysicsObject* obj)
+{
+	DetachObject(obj);
+
+	// the body's destructor frees its slot in the store
+	if (obj->pool.index < 0)
+		delete obj;
+	else if (obj->oType == PhysicsObject::CIRCLE)
+		circlePool.Destroy(obj->pool);
+	else if (obj->oType == PhysicsObject::BOX)
+		boxPool.Destroy(obj->pool);
+	else
+		springPool.Destroy(obj->pool);
+}
+
+// takes the object out of the world, without deleting it
+void PhysicsWorld::DetachObject(PhysicsObject* obj)
+{
+	// whatever was resting on it needs to notice it's gone. A moving body can only be touching its own island,
+	// but anything fixed could be holding up any number of them
+	bool fixed = obj->oType == PhysicsObject::PLANE || (IsRigidBody(obj) && ((RigidBody*)obj)->IsFixed());
+	for (int id = 0; fixed && id < (int)m_sleepingIslands.size(); id++)
+	{
+		for (auto& contact : m_sleepingIslands[id].contacts)
+		{
+			if (contact.a == obj || contact.b == obj || contact.plane == obj)
+			{
+				WakeIsland(id);
+				break;
+			}
+		}
+	}
+
+	if (IsRigidBody(obj))
+	{
+		Wake((RigidBody*)obj);
+		m_broadphase->RemoveBody((RigidBody*)obj);
+		if (obj->oType == PhysicsObject::BOX && ((Box*)obj)->IsFixed())
+			m_fixedBoxes.erase(std::find(m_fixedBoxes.begin(), m_fixedBoxes.end(), (Box*)obj));
+	}
+	else if (obj->oType == PhysicsObject::PLANE)
+		m_planes.erase(std::find(m_planes.begin(), m_planes.end(), (Plane*)obj));
+
+	if (obj->HasUpdate())
+		m_updateObjects.erase(std::find(m_updateObjects.begin(), m_updateObjects.end(), obj));
+}
+
+void PhysicsWorld::Clear()
+{
+	// everything's going, so rather than taking each object out of the broadphase, the lists and the store one
+	// at a time, they're all emptied in one go and the objects just deleted
+	for (auto obj : m_physicsObjects)
+	{
+		if (IsRigidBody(obj))
+			((RigidBody*)obj)->store = nullptr;
+		if (obj->pool.index < 0)
+			delete obj;
+	}
+	m_physicsObjects.clear();
+	m_planes.clear();
+	m_fixedBoxes.clear();
+	m_updateObjects.clear();
+	circlePool.Clear();
+	boxPool.Clear();
+	springPool.Clear();
+
+	particleSystem.Clear();
+
+	for (auto& bucket : m_expiryWheel)
+		bucket.clear();
+	m_numTransient = 0;
+
+	// handles get reused, so forget the old contacts or new bodies could pick up their impulses
+	m_pairs.clear();
+	m_contacts.clear();
+	m_previousContacts.clear();
+	m_previousKeys.clear();
+	m_sleepingIslands.clear();
+	m_freeSleepingIslands.clear();
+	m_handleIsland.clear();
+
+	// start again from scratch, so a cleared world is the same as a new one and replays add up
+	bodies.Clear();
+	SetBroadphase(m_broadphase->GetType());
+	m_stepCount = 0;
+	m_accumulator = 0;
+}
+
+PhysicsWorld* PhysicsWorld::Clone()
+{
+	Snapshot snapshot;
+	snapshot.Capture(*this);
+
+	// the snapshot makes the copy's objects from scratch, joining its springs to its own bodies by handle
+	PhysicsWorld* copy = new PhysicsWorld();
+	copy->instructionSet = instructionSet;
+	copy->numThreads = numThreads;
+	snapshot.Restore(*copy);
+	return copy;
+}
+
+void PhysicsWorld::SetBroadphase(Broadphase::BroadphaseType type)
+{
+	if (recording)
+		recording->RecordBroadphase(type);
+
+	// the old broadphase is thrown away whole, so there's no need to take the bodies out of it one by one.
+	// Adding them to the new one gives them their new proxies
+	Broadphase* broadphase = Broadphase::Create(type);
+	for (auto it = m_physicsObjects.begin(); it != m_physicsObjects.end(); it++)
+	{
+		if (IsRigidBody(*it))
+			broadphase->AddBody((RigidBody*)*it);
+	}
+	delete m_broadphase;
+	m_broadphase = broadphase;
+	m_broadphase->jobs = m_jobs;
+}
+
+// removes everything whose time is up in one go. Objects are marked with a negative life span and taken out of
+// m_physicsObjects in a single pass
+void PhysicsWorld::ExpireObjects()
+{
+	std::vector<Expiry>& bucket = m_expiryWheel[m_stepCount & (m_expiryWheel.size() - 1)];
+	for (auto& expiry : bucket)
+		expiry.obj->lifeSpan = -1;
+	bool anyObjects = !bucket.empty();
+	m_numTransient -= (int)bucket.size();
+	bucket.clear();
+
+	if (anyObjects)
+	{
+		auto end = std::remove_if(m_physicsObjects.begin(), m_physicsObjects.end(), [this](PhysicsObject* obj)
+		{
+			if (obj->lifeSpan >= 0)
+				return false;
+			RemoveObject(obj);
+			return true;
+		});
+		m_physicsObjects.erase(end, m_physicsObjects.end());
+	}
+}
+
+// moves every body on by one time step, working straight on the arrays in the body store
+void PhysicsWorld::IntegrateBodies()
+{
+	int count = bodies.AwakeCount();
+	m_bulletStarts.clear();
+	for (int i = 0; i < count; i++)
+	{
+		if (bodies.flags[i] & BodyStore::BULLET)
+			m_bulletStarts.push_back({ i, bodies.position[i] });
+	}
+
+	Integrator::Integrate(instructionSet, bodies, 0, count, m_stepDt, gravity);
+}
+
+// continuous collision. Each bullet is pulled back to the first plane or box it would have hit on the way to where
+// it's been integrated to, so the narrowphase finds the contact rather than it passing straight through.
+// Only bullets pay for this, everything else is just tested where it ends up.
+void PhysicsWorld::SweepBullets()
+{
+	for (auto& bullet : m_bulletStarts)
+	{
+		RigidBody* body = bodies.body[bullet.index];
+		if (body->oType != PhysicsObject::CIRCLE)
+			continue;
+
+		Circle* circle = (Circle*)body;
+		glm::vec2 start = bullet.position, end = bodies.position[bullet.index];
+		if (start == end)
+			continue;
+
+		float t = 1;
+		for (auto plane : m_planes)
+			t = std::min(t, circle->TimeOfImpact(plane, start, end));
+
+		glm::vec2 radius(circle->radius, circle->radius);
+		m_queryResults.clear();
+		m_broadphase->Query({ glm::min(start, end) - radius, glm::max(start, end) + radius }, m_queryResults);
+		for (auto other : m_queryResults)
+		{
+			if (other->oType == PhysicsObject::BOX)
+				t = std::min(t, circle->TimeOfImpact((Box*)other, start, end, m_stepDt));
+		}
+
+		if (t < 1)
+			bodies.position[bullet.index] = start + (end - start) * t;
+	}
+}
+
+void PhysicsWorld::Step()
+{
+	PROFILE_SCOPE(profiler, Profiler::STEP);
+	numContacts = 0;
+
+	if (recording)
+		recording->RecordInput(input);
+
+	if (!m_jobs || m_jobThreads != numThreads)
+	{
+		delete m_jobs;
+		m_jobs = new JobSystem(numThreads);
+		m_jobThreads = numThreads;
+		m_broadphase->jobs = m_jobs;
+	}
+
+	// get rid of anything that's reached the end of its life
+	m_stepCount++;
+	if (m_numTransient > 0)
+	{
+		PROFILE_SCOPE(profiler, Profiler::EXPIRE);
+		ExpireObjects();
+	}
+
+	// remember where everything was, for drawing in between this step and the next
+	bodies.previousPosition = bodies.position;
+	bodies.previousAngle = bodies.angle;
+
+	m_stepDt = dt / substeps;
+	for (int i = 0; i < substeps; i++)
+		SubStep();
+
+	// particles don't affect the bodies, so they just take one step after them
+	{
+		PROFILE_SCOPE(profiler, Profiler::PARTICLES);
+		particleSystem.Update(instructionSet, dt, gravity, m_planes, m_fixedBoxes);
+	}
+	interpolation = 1;
+
+	if (telemetry.WantsSample(m_stepCount))
+		RecordTelemetry();
+	if (recording)
+		recording->RecordStep(StateHash());
+}
+
+void PhysicsWorld::SubStep()
+{
+	// springs, player controls etc.
+	{
+		PROFILE_SCOPE(profiler, Profiler::SPRINGS);
+		for (unsigned int i = 0; i < m_updateObjects.size(); i++)
+			m_updateObjects[i]->Update(m_stepDt);
+	}
+
+	{
+		PROFILE_SCOPE(profiler, Profiler::INTEGRATE);
+		IntegrateBodies();
+		if (!m_bulletStarts.empty())
+			SweepBullets();
+	}
+
+	// find the bodies that the broadphase thinks might be touching, test them properly, then respond island by island
+	{
+		PROFILE_SCOPE(profiler, Profiler::BROADPHASE);
+		m_pairs.clear();
+		m_broadphase->FindPairs(m_pairs);
+
+		// anything asleep that an awake body has come near wakes up, along with the rest of its island.
+		// Its pairs weren't found while it was asleep, so look again
+		while (WakeTouchedIslands())
+		{
+			m_pairs.clear();
+			m_broadphase->FindPairs(m_pairs);
+		}
+	}
+
+	{
+		PROFILE_SCOPE(profiler, Profiler::NARROWPHASE);
+		FindContacts();
+	}
+
+	PROFILE_SCOPE(profiler, Profiler::SOLVE);
+	MatchContacts();
+	BuildIslands();
+	SolveIslands();
+	StoreContacts();
+	SleepIslands();
+}
+
+int PhysicsWorld::Advance(float elapsed)
+{
+	m_accumulator += elapsed;
+
+	int steps = 0, contacts = 0;
+	while (m_accumulator >= dt && steps < maxSteps)
+	{
+		Step();
+		contacts += numContacts;
+		m_accumulator -= dt;
+		steps++;
+	}
+	numContacts = contacts;
+
+	// couldn't keep up, so let the time go
+	if (m_accumulator >= dt)
+		m_accumulator = fmodf(m_accumulator, dt);
+
+	interpolation = m_accumulator / dt;
+	return steps;
+}
+
+PhysicsWorld::ContactKey PhysicsWorld::MakeKey(const ContactManifold& contact, int index)
+{
+	return { contact.a->handle, contact.b ? contact.b->handle : -1, contact.plane, index };
+}
+
+// picks up last step's impulses for any contact points that are still there, matching them by feature id
+void PhysicsWorld::MatchContacts()
+{
+	if (m_previousKeys.empty())
+		return;
+
+	// islands that have just woken up add their contacts unsorted
+	if (!m_previousKeysSorted)
+	{
+		std::sort(m_previousKeys.begin(), m_previousKeys.end());
+		m_previousKeysSorted = true;
+	}
+
+	for (auto& contact : m_contacts)
+	{
+		ContactKey key = MakeKey(contact, 0);
+		auto it = std::lower_bound(m_previousKeys.begin(), m_previousKeys.end(), key);
+		if (it == m_previousKeys.end() || key < *it)
+			continue;
+
+		const ContactManifold& previous = m_previousContacts[it->index];
+		for (int i = 0; i < contact.numPoints; i++)
+		{
+			for (int j = 0; j < previous.numPoints; j++)
+			{
+				if (contact.points[i].id == previous.points[j].id)
+				{
+					contact.points[i].normalImpulse = previous.points[j].normalImpulse;
+					break;
+				}
+			}
+		}
+	}
+}
+
+// keeps this step's contacts for warm starting the next one
+void PhysicsWorld::StoreContacts()
+{
+	m_previousContacts = m_contacts;
+	m_previousKeys.resize(m_contacts.size());
+	for (unsigned int i = 0; i < m_contacts.size(); i++)
+		m_previousKeys[i] = MakeKey(m_contacts[i], i);
+	std::sort(m_previousKeys.begin(), m_previousKeys.end());
+	m_previousKeysSorted = true;
+}
+
+// the narrowphase. The pairs, and every body against every plane, are split into chunks that are tested in parallel,
+// each chunk writing to its own buffer. The buffers are joined back up in order afterwards.
+void PhysicsWorld::FindContacts()
+{
+	narrowphase.Run(m_jobs, instructionSet, bodies, m_pairs, m_planes, m_contacts);
+}
+
+// splits the awake bodies into islands: the connected groups you get by following contacts and springs.
+// Awake bodies come first in the store, so anything past AwakeCount() is fixed or asleep and belongs to no island
+void PhysicsWorld::BuildIslands()
+{
+	int count = bodies.AwakeCount();
+	m_islandParent.resize(count);
+	for (int i = 0; i < count; i++)
+		m_islandParent[i] = i;
+
+	for (auto& contact : m_contacts)
+	{
+		if (!contact.b)
+			continue;
+		int a = contact.a->Index(), b = contact.b->Index();
+		if (a < count && b < count)
+			Join(m_islandParent, a, b);
+	}
+
+	for (auto obj : m_updateObjects)
+	{
+		if (obj->oType != PhysicsObject::SPRING)
+			continue;
+		Spring* spring = (Spring*)obj;
+		int a = spring->body1->Index(), b = spring->body2->Index();
+		if (a < count && b < count)
+			Join(m_islandParent, a, b);
+	}
+
+	// number the islands in order of their lowest body. Roots always come before the rest of their island.
+	m_islands.clear();
+	m_bodyIsland.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		int root = FindRoot(m_islandParent, i);
+		if (root == i)
+		{
+			m_bodyIsland[i] = (int)m_islands.size();
+			m_islands.push_back({ 0, 0, 0, 0 });
+		}
+		else
+			m_bodyIsland[i] = m_bodyIsland[root];
+		m_islands[m_bodyIsland[i]].numBodies++;
+	}
+
+	// a contact belongs to the island of whichever body isn't fixed
+	int numContacts = (int)m_contacts.size();
+	m_contactIsland.resize(numContacts);
+	for (int i = 0; i < numContacts; i++)
+	{
+		int a = m_contacts[i].a->Index();
+		int island = a < count ? m_bodyIsland[a] : m_bodyIsland[m_contacts[i].b->Index()];
+		m_contactIsland[i] = island;
+		m_islands[island].numContacts++;
+	}
+
+	// then sort the bodies and contacts by island, keeping them in their original order within each one
+	int firstBody = 0, firstContact = 0;
+	for (auto& island : m_islands)
+	{
+		island.firstBody = firstBody;
+		island.firstContact = firstContact;
+		firstBody += island.numBodies;
+		firstContact += island.numContacts;
+		island.numBodies = 0;
+		island.numContacts = 0;
+	}
+
+	m_islandBodies.resize(firstBody);
+	for (int i = 0; i < count; i++)
+	{
+		Island& island = m_islands[m_bodyIsland[i]];
+		m_islandBodies[island.firstBody + island.numBodies++] = i;
+	}
+
+	m_islandContacts.resize(firstContact);
+	for (int i = 0; i < numContacts; i++)
+	{
+		Island& island = m_islands[m_contactIsland[i]];
+		m_islandContacts[island.firstContact + island.numContacts++] = i;
+	}
+}
+
+void PhysicsWorld::SolveIslands()
+{
+	// group small islands together so each job has a worthwhile amount of work in it
+	m_batches.clear();
+	int cost = 0;
+	for (int i = 0; i < (int)m_islands.size(); i++)
+	{
+		if (cost == 0)
+			m_batches.push_back({ i, 0 });
+		m_batches.back().numIslands++;
+		cost += m_islands[i].numContacts;
+		if (cost >= ISLAND_BATCH_COST)
+			cost = 0;
+	}
+
+	int numBatches = (int)m_batches.size();
+	while ((int)m_solvers.size() < numBatches)
+		m_solvers.push_back(new SolverBatch());
+
+	m_bodySlot.resize(bodies.Count());
+	m_jobs->ParallelFor(numBatches, [this](int b)
+	{
+		ContactSolver& solver = m_solvers[b]->solver;
+		solver.dt = m_stepDt;
+		solver.velocityIterations = velocityIterations;
+		solver.positionIterations = positionIterations;
+		solver.debugDraw = debugDraw ? &m_solvers[b]->draw : nullptr;
+
+		IslandBatch& batch = m_batches[b];
+		for (int i = 0; i < batch.numIslands; i++)
+			SolveIsland(batch.firstIsland + i, solver);
+	});
+
+	for (int b = 0; b < numBatches; b++)
+	{
+		SolverBatch* batch = m_solvers[b];
+		numContacts += batch->solver.numSolved;
+		if (debugDraw)
+			batch->draw.Replay(debugDraw);
+		batch->solver.numSolved = 0;
+		batch->draw.Clear();
+	}
+}
+
+// the island's contacts in the order the narrowphase found them, so pairs come before planes
+void PhysicsWorld::SolveIsland(int index, ContactSolver& solver)
+{
+	Island& island = m_islands[index];
+	solver.SolveIsland(bodies, m_islandBodies.data() + island.firstBody, island.numBodies, m_bodySlot.data(),
+		m_contacts, m_islandContacts.data() + island.firstContact, island.numContacts);
+}
+
+float PhysicsWorld::getEnergy(float& k, float& g, float& r)
+{
+	k = 0; g = 0; r = 0;
+	int count = bodies.Count();
+	for (int i = 0; i < count; i++)
+	{
+		// fixed bodies have infinite mass but never move, so leave them out
+		if (bodies.invMass[i] == 0)
+			continue;
+		float mass = 1.0f / bodies.invMass[i];
+		g += -mass * glm::dot(bodies.position[i], gravity);
+		k += 0.5f * mass * glm::dot(bodies.velocity[i], bodies.velocity[i]);
+		r += 0.5f * bodies.rotation[i] * bodies.rotation[i] / bodies.invMoment[i];
+	}
+	return k + g + r;
+}
+
+void PhysicsWorld::RecordTelemetry()
+{
+	TelemetrySample sample;
+	sample.step = m_stepCount;
+	sample.time = m_stepCount * dt;
+	getEnergy(sample.kinetic, sample.potential, sample.rotational);
+	sample.bodies = bodies.Count();
+	sample.awake = bodies.AwakeCount();
+	sample.pairs = (int)m_pairs.size();
+	sample.contacts = numContacts;
+	sample.particles = particleSystem.Count();
+	telemetry.Record(sample);
+}
+
+void PhysicsWorld::QueryPoint(glm::vec2 pt, std::vector<RigidBody*>& results)
+{
+	m_queryResults.clear();
+	m_broadphase->Query({ pt, pt }, m_queryResults);
+	for (auto body : m_queryResults)
+	{
+		if (body->IsInside(pt))
+			results.push_back(body);
+	}
+}
+
+void PhysicsWorld::ApplyForce(RigidBody* body, glm::vec2 force, glm::vec2 point)
+{
+	if (recording)
+		recording->RecordForce(body->handle, force, point);
+	body->ApplyForce(force, point);
+}
+
+// FNV-1a, a word at a time
+static void HashWords(unsigned long long& hash, const void* data, size_t bytes)
+{
+	const unsigned int* words = (const unsigned int*)data;
+	for (size_t i = 0; i < bytes / 4; i++)
+	{
+		hash ^= words[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+unsigned long long PhysicsWorld::StateHash()
+{
+	unsigned long long hash = 14695981039346656037ull;
+	int count = bodies.Count();
+	HashWords(hash, bodies.position.data(), count * sizeof(glm::vec2));
+	HashWords(hash, bodies.velocity.data(), count * sizeof(glm::vec2));
+	HashWords(hash, bodies.angle.data(), count * sizeof(float));
+	HashWords(hash, bodies.rotation.data(), count * sizeof(float));
+	HashWords(hash, bodies.handle.data(), count * sizeof(int));
+
+	// flags are bytes, and the awake count covers whether each body's asleep
+	int awake = bodies.AwakeCount();
+	HashWords(hash, &awake, sizeof(awake));
+
+	int particleCount = particleSystem.Count();
+	HashWords(hash, particleSystem.x.data(), particleCount * sizeof(float));
+	HashWords(hash, particleSystem.y.data(), particleCount * sizeof(float));
+	return hash;
+}
+
+void PhysicsWorld::Wake(RigidBody* body)
+{
+	if (body->IsAwake() || body->IsFixed())
+		return;
+
+	int handle = body->handle;
+	int id = handle < (int)m_handleIsland.size() ? m_handleIsland[handle] : -1;
+	if (id >= 0)
+		WakeIsland(id);
+	else
+		bodies.Wake(body->Index());
+}
+
+void PhysicsWorld::WakeIsland(int id)
+{
+	SleepingIsland& island = m_sleepingIslands[id];
+	for (int handle : island.handles)
+	{
+		m_handleIsland[handle] = -1;
+		bodies.Wake(bodies.Index(handle));
+	}
+
+	// hand its contacts back so they're matched and warm started next time round
+	for (auto& contact : island.contacts)
+	{
+		m_previousKeys.push_back(MakeKey(contact, (int)m_previousContacts.size()));
+		m_previousContacts.push_back(contact);
+	}
+	m_previousKeysSorted = false;
+
+	island.handles.clear();
+	island.contacts.clear();
+	m_freeSleepingIslands.push_back(id);
+}
+
+// any pair with a sleeping body in it must have an awake one too, which has come close enough to wake it
+bool PhysicsWorld::WakeTouchedIslands()
+{
+	bool woken = false;
+	for (auto& pair : m_pairs)
+	{
+		RigidBody* sleeper = pair.a->IsAwake() ? pair.b : pair.a;
+		if (!sleeper->IsAwake() && !sleeper->IsFixed())
+		{
+			Wake(sleeper);
+			woken = true;
+		}
+	}
+	return woken;
+}
+
+// puts islands to sleep once all their bodies have been slow for timeToSleep. Their contacts are put to one side
+// for when they wake, so they cost nothing in the meantime
+void PhysicsWorld::SleepIslands()
+{
+	if (timeToSleep < 0)
+		return;
+
+	m_sleepingHandles.clear();
+	for (int i = 0; i < (int)m_islands.size(); i++)
+	{
+		Island& island = m_islands[i];
+		const int* members = m_islandBodies.data() + island.firstBody;
+		bool quiet = true;
+		for (int j = 0; j < island.numBodies && quiet; j++)
+			quiet = bodies.sleepTime[members[j]] >= timeToSleep;
+		if (!quiet)
+			continue;
+
+		int id;
+		if (m_freeSleepingIslands.empty())
+		{
+			id = (int)m_sleepingIslands.size();
+			m_sleepingIslands.emplace_back();
+		}
+		else
+		{
+			id = m_freeSleepingIslands.back();
+			m_freeSleepingIslands.pop_back();
+		}
+
+		SleepingIsland& sleeping = m_sleepingIslands[id];
+		for (int j = 0; j < island.numBodies; j++)
+		{
+			int handle = bodies.handle[members[j]];
+			if (handle >= (int)m_handleIsland.size())
+				m_handleIsland.resize(handle + 1, -1);
+			m_handleIsland[handle] = id;
+			sleeping.handles.push_back(handle);
+			m_sleepingHandles.push_back(handle);
+		}
+		for (int j = 0; j < island.numContacts; j++)
+			sleeping.contacts.push_back(m_contacts[m_islandContacts[island.firstContact + j]]);
+	}
+
+	// putting a body to sleep moves others around in the store, so only go by handle from here
+	for (int handle : m_sleepingHandles)
+		bodies.Sleep(bodies.Index(handle));
+}
\ No newline at end of file
@@ -0,0 +1,285 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+#include <functional>
+#include <vector>
+
+#include "PhysicsObject.h"
+#include "Broadphase.h"
+#include "BodyStore.h"
+#include "Integrator.h"
+#include "DebugDrawBuffer.h"
+#include "ContactSolver.h"
+#include "Narrowphase.h"
+#include "ObjectPool.h"
+#include "Circle.h"
+#include "Box.h"
+#include "Spring.h"
+#include "ParticleSystem.h"
+#include "Profiler.h"
+#include "Telemetry.h"
+
+class DebugDraw;
+class JobSystem;
+class Replay;
+
+// owns all the physics objects and steps them. Has no dependency on OpenGL or GLFW,
+// so it can be run headless as well as inside PhysicsApplication.
+class PhysicsWorld
+{
+public:
+	enum InputFlags
+	{
+		INPUT_THRUST_LEFT = 1,
+		INPUT_THRUST_RIGHT = 2,
+	};
+
+	PhysicsWorld() { m_broadphase = Broadphase::Create(Broadphase::AABB_TREE); }
+	~PhysicsWorld();
+
+	// the world takes ownership of the object and deletes it when it expires or on Clear()
+	void AddObject(PhysicsObject* obj, bool atFront = false);
+	// build objects in blocks belonging to the world rather than allocating each one, for scenes with a lot of them.
+	// They still need adding with AddObject(), and are destroyed by the world like anything else
+	Circle* NewCircle(glm::vec2 position, glm::vec2 velocity, float radius, float density);
+	Box* NewBox(glm::vec2 position, glm::vec2 velocity, float angle, float width, float height, float density, bool fixed);
+	Spring* NewSpring(RigidBody* body1, RigidBody* body2, float restLength, float restoringForce, glm::vec2 contact1, glm::vec2 contact2);
+	void Clear();
+
+	// a new world in the same state as this one, with its own copy of every object, and springs joined to the
+	// copy's bodies rather than this world's. Copies step exactly the same as each other, but as with restoring a
+	// Snapshot, not always the same as the world they were copied from. The caller deletes it
+	PhysicsWorld* Clone();
+
+	// one fixed step of dt, made up of substeps smaller steps. Headless runs just call this as fast as they can
+	void Step();
+
+	// for real time. Adds the time that's passed to the accumulator and takes as many fixed steps as fit in it,
+	// carrying what's left over to the next call. Returns the number of steps taken.
+	int Advance(float elapsed);
+
+	// wakes the body and everything in its island. Touching or pulling on a body with a spring wakes it anyway
+	void Wake(RigidBody* body);
+
+	// pushes a body from outside the simulation, such as with the mouse. Goes in the recording, unlike calling
+	// the body's ApplyForce() directly, which is for forces that come from inside the world
+	void ApplyForce(RigidBody* body, glm::vec2 force, glm::vec2 point);
+
+	// a hash of every body's state and every particle's position. Two worlds that have been set up and stepped
+	// the same way hash the same, whatever the thread count or instruction set
+	unsigned long long StateHash();
+
+	// swaps the broadphase, moving every body across to the new one
+	void SetBroadphase(Broadphase::BroadphaseType type);
+
+	float getEnergy(float& k, float& g, float& r);
+
+	// every body containing the point
+	void QueryPoint(glm::vec2 pt, std::vector<RigidBody*>& results);
+	// the first body hit by the line from start to end
+	RigidBody* RayCast(glm::vec2 start, glm::vec2 end, float& fraction) { return m_broadphase->RayCast(start, end, fraction); }
+
+	// kept in a vector rather than a list, so adding a million objects isn't a million allocations
+	std::vector<PhysicsObject*> m_physicsObjects;
+
+	// the state of every rigid body, in structure of arrays form
+	BodyStore bodies;
+
+	glm::vec2 gravity = glm::vec2(0, -1);
+	float dt = 1.0f / 60.0f;
+
+	// each step is split into this many smaller ones, which makes stacks and springs stiffer at the cost of speed
+	int substeps = 1;
+
+	// most steps one Advance() will take. If stepping can't keep up with real time the rest of the time is
+	// dropped, slowing the simulation down rather than falling further and further behind
+	int maxSteps = 8;
+
+	// how far through the next step real time has got to, from 0 to 1. Bodies are drawn this far between
+	// where they were at the start of the last step and where they are now
+	float interpolation = 1;
+
+	// which SIMD path integrates the bodies. They all give identical results, so this only affects speed
+	Integrator::InstructionSet instructionSet = Integrator::Best();
+
+	// threads used for collision detection and solving islands, 0 for one per core. Again the results are the same whatever this is
+	int numThreads = 0;
+
+	// passes the contact solver makes over each island. More iterations make stacks stiffer and slower to solve
+	int velocityIterations = 8;
+	int positionIterations = 3;
+
+	// how long every body in an island has to have been moving slowly before the whole island goes to sleep.
+	// Sleeping islands aren't integrated, tested against each other or solved until something wakes them. Negative never sleeps
+	float timeToSleep = 0.5f;
+
+	// control state for player driven objects, set before each Step()
+	unsigned int input = 0;
+
+	// optional, used to visualise contacts as they are resolved
+	DebugDraw* debugDraw = nullptr;
+
+	// number of collisions resolved during the last Step()
+	int numContacts = 0;
+
+	Broadphase* m_broadphase;
+
+	// planes are infinite, so rather than going in the broadphase they're tested against every body
+	std::vector<Plane*> m_planes;
+	// what the particle system collides with besides the planes
+	std::vector<Box*> m_fixedBoxes;
+
+	// candidate pairs found by the broadphase in the last Step()
+	std::vector<BroadphasePair> m_pairs;
+
+	// tests them, and the bodies against the planes, keeping counts and timings for each kind of pair in its stats
+	Narrowphase narrowphase;
+
+	// what the narrowphase made of them, plus the plane contacts
+	std::vector<ContactManifold> m_contacts;
+
+	// objects that need their Update() called, such as springs
+	std::vector<PhysicsObject*> m_updateObjects;
+
+	// what NewCircle() and the rest build their objects in
+	ObjectPool<Circle, 4096> circlePool;
+	ObjectPool<Box, 4096> boxPool;
+	ObjectPool<Spring, 4096> springPool;
+
+	// exhaust and debris. Moved once a step after the bodies, bouncing off planes and fixed boxes
+	ParticleSystem particleSystem;
+
+	// times each phase of Step(). Whoever drives the world calls its EndFrame() once a frame
+	Profiler profiler;
+
+	// energies and counts, written to a file in the background every sampleInterval steps once it's started
+	Telemetry telemetry;
+
+	// set by Replay::Start() while the world's being recorded
+	Replay* recording = nullptr;
+
+private:
+	// reads and writes the private state directly, so it can be copied in and out in bulk
+	friend class Snapshot;
+
+	void SubStep();
+	void RemoveObject(PhysicsObject* obj);
+	void DetachObject(PhysicsObject* obj);
+	void AddExpiry(PhysicsObject* obj, int lifeSpan);
+	void ExpireObjects();
+	void RecordTelemetry();
+	void IntegrateBodies();
+	void SweepBullets();
+	void FindContacts();
+	void MatchContacts();
+	void StoreContacts();
+	void BuildIslands();
+	void SolveIslands();
+	void SolveIsland(int island, ContactSolver& solver);
+	bool WakeTouchedIslands();
+	void WakeIsland(int id);
+	void SleepIslands();
+
+	std::vector<RigidBody*> m_queryResults;
+
+	// where each bullet started the step, so it can be swept from there to where it's been integrated to
+	struct BulletStart
+	{
+		int index;
+		glm::vec2 position;
+	};
+
+	std::vector<BulletStart> m_bulletStarts;
+
+	// an island is a group of bodies linked by contacts or springs. Nothing in one island can affect another,
+	// so they can be solved in any order, on any thread. Fixed bodies aren't part of any island.
+	struct Island
+	{
+		int firstBody, numBodies;
+		int firstContact, numContacts;
+	};
+
+	// consecutive islands solved together as one job
+	struct IslandBatch
+	{
+		int firstIsland, numIslands;
+	};
+
+	std::vector<Island> m_islands;
+	std::vector<IslandBatch> m_batches;
+	std::vector<int> m_islandParent;
+	std::vector<int> m_bodyIsland;
+	std::vector<int> m_contactIsland;
+	// body and contact indices, sorted by island
+	std::vector<int> m_islandBodies;
+	std::vector<int> m_islandContacts;
+
+	// identifies the same touching pair from one step to the next
+	struct ContactKey
+	{
+		int a, b;
+		Plane* plane;
+		int index;
+
+		bool operator<(const ContactKey& other) const
+		{
+			if (a != other.a)
+				return a < other.a;
+			if (b != other.b)
+				return b < other.b;
+			return std::less<Plane*>()(plane, other.plane);
+		}
+	};
+
+	static ContactKey MakeKey(const ContactManifold& contact, int index);
+
+	// last step's contacts, and keys for them sorted so this step's can be looked up and warm started
+	std::vector<ContactManifold> m_previousContacts;
+	std::vector<ContactKey> m_previousKeys;
+	// false when woken islands have added keys that haven't been sorted in yet
+	bool m_previousKeysSorted = true;
+
+	// an island that's gone to sleep, with its contacts kept to warm start from when it wakes
+	struct SleepingIsland
+	{
+		std::vector<int> handles;
+		std::vector<ContactManifold> contacts;
+	};
+
+	std::vector<SleepingIsland> m_sleepingIslands;
+	std::vector<int> m_freeSleepingIslands;
+	// which sleeping island each body handle is in, or -1
+	std::vector<int> m_handleIsland;
+	// bodies going to sleep at the end of this step
+	std::vector<int> m_sleepingHandles;
+	// a solver for each batch of islands, with what it drew, so batches can run on different threads.
+	// They're merged in batch order so the totals and drawing don't depend on which thread did what
+	struct SolverBatch
+	{
+		ContactSolver solver;
+		DebugDrawBuffer draw;
+	};
+
+	std::vector<SolverBatch*> m_solvers;
+	// each body's place in its island, for the solver
+	std::vector<int> m_bodySlot;
+
+	// objects with a limited life span, bucketed by the step they expire on modulo the number of
+	// buckets. There are always more buckets than the longest life span, so each step just empties one bucket
+	struct Expiry
+	{
+		int step;
+		PhysicsObject* obj;
+	};
+
+	std::vector<std::vector<Expiry>> m_expiryWheel;
+	int m_numTransient = 0;
+	int m_stepCount = 0;
+
+	// time passed to Advance() that hasn't been stepped yet
+	float m_accumulator = 0;
+	// length of the substep being taken
+	float m_stepDt = 0;
+
+	JobSystem* m_jobs = nullptr;
+	int m_jobThreads = 0;
+};
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <stdio.h>
+
+#include "Profiler.h"
+
+const char* Profiler::PhaseName(int phase)
+{
+	static const char* names[NUM_PHASES] =
+	{
+		"step", "expire", "springs", "integrate", "broadphase", "narrowphase", "solve", "particles", "draw",
+	};
+	return names[phase];
+}
+
+Profiler::Profiler()
+{
+	for (auto& history : m_history)
+		history.resize(HISTORY);
+	Reset();
+}
+
+void Profiler::Add(Phase phase, Clock::time_point start, Clock::time_point end)
+{
+	double duration = std::chrono::duration<double, std::milli>(end - start).count();
+	m_current[phase] += duration;
+
+	if (m_tracing && (int)m_events.size() < maxTraceEvents)
+	{
+		Event event;
+		event.phase = phase;
+		event.frame = m_numFrames;
+		event.start = std::chrono::duration<double, std::micro>(start - m_traceStart).count();
+		event.duration = duration * 1000.0;
+		m_events.push_back(event);
+	}
+}
+
+void Profiler::EndFrame()
+{
+	for (int phase = 0; phase < NUM_PHASES; phase++)
+	{
+		m_history[phase][m_frame] = m_current[phase];
+		m_total[phase] += m_current[phase];
+		m_current[phase] = 0;
+	}
+	m_frame = (m_frame + 1) % HISTORY;
+	m_numFrames++;
+}
+
+Profiler::Stats Profiler::GetStats(int phase)
+{
+	Stats stats = {};
+	stats.frames = std::min(m_numFrames, (int)HISTORY);
+	stats.total = m_total[phase];
+	if (stats.frames == 0)
+		return stats;
+
+	m_sorted.assign(m_history[phase].begin(), m_history[phase].begin() + stats.frames);
+	std::sort(m_sorted.begin(), m_sorted.end());
+
+	double total = 0;
+	for (double ms : m_sorted)
+		total += ms;
+
+	stats.min = m_sorted.front();
+	stats.max = m_sorted.back();
+	stats.avg = total / stats.frames;
+	// nearest rank, so with fewer than 100 frames it's the slowest one
+	stats.p99 = m_sorted[(stats.frames * 99 + 99) / 100 - 1];
+	return stats;
+}
+
+void Profiler::Print()
+{
+	printf("%-12s %9s %9s %9s %9s  (ms over %d frames)\n", "phase", "min", "avg", "p99", "max", std::min(m_numFrames, (int)HISTORY));
+	for (int phase = 0; phase < NUM_PHASES; phase++)
+	{
+		Stats stats = GetStats(phase);
+		printf("%-12s %9.3f %9.3f %9.3f %9.3f\n", PhaseName(phase), stats.min, stats.avg, stats.p99, stats.max);
+	}
+}
+
+void Profiler::Reset()
+{
+	for (int phase = 0; phase < NUM_PHASES; phase++)
+	{
+		m_current[phase] = 0;
+		m_total[phase] = 0;
+		std::fill(m_history[phase].begin(), m_history[phase].end(), 0.0);
+	}
+	m_frame = 0;
+	m_numFrames = 0;
+}
+
+void Profiler::StartTrace()
+{
+	m_events.clear();
+	m_traceStart = Clock::now();
+	m_tracing = true;
+}
+
+bool Profiler::WriteTrace(const char* path)
+{
+	m_tracing = false;
+
+	FILE* file = fopen(path, "w");
+	if (!file)
+		return false;
+
+	// complete ("X") events, all on one thread. Chrome works out the nesting from the times
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (size_t i = 0; i < m_events.size(); i++)
+	{
+		const Event& event = m_events[i];
+		fprintf(file, "{\"name\":\"%s\",\"cat\":\"physics\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d}}%s\n",
+			PhaseName(event.phase), event.start, event.duration, event.frame, i + 1 < m_events.size() ? "," : "");
+	}
+	fprintf(file, "]}\n");
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+	m_events.clear();
+	return ok;
+}
\ No newline at end of file
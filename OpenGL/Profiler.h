@@ -0,0 +1,110 @@
+#pragma once
+#include <chrono>
+#include <vector>
+
+// build with PHYSICS_PROFILE set to 0 to compile the timers out altogether. PROFILE_SCOPE then expands to nothing,
+// and the profiler is left with no samples
+#ifndef PHYSICS_PROFILE
+#define PHYSICS_PROFILE 1
+#endif
+
+#if PHYSICS_PROFILE
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+// times from here to the end of the enclosing block as the given phase
+#define PROFILE_SCOPE(profiler, phase) Profiler::Scope PROFILE_JOIN(profileScope, __LINE__)(profiler, phase)
+#else
+#define PROFILE_SCOPE(profiler, phase)
+#endif
+
+// times each phase of a frame. Time spent in a phase is added up over the frame, however many steps and substeps
+// it takes, and EndFrame() files the totals away, keeping the last HISTORY frames to work out the stats from.
+// It can also record every timed scope as an event, to be written out as a Chrome trace (chrome://tracing or Perfetto).
+// Scopes must only be opened on the thread that steps the world.
+class Profiler
+{
+public:
+	enum Phase
+	{
+		STEP,
+		EXPIRE,
+		SPRINGS,
+		INTEGRATE,
+		BROADPHASE,
+		NARROWPHASE,
+		SOLVE,
+		PARTICLES,
+		DRAW,
+		NUM_PHASES,
+	};
+
+	// frames kept for the stats
+	enum { HISTORY = 240 };
+
+	static const char* PhaseName(int phase);
+
+	// times over the frames in the history, in milliseconds, plus the total since the last Reset()
+	struct Stats
+	{
+		double min, avg, p99, max;
+		int frames;
+		double total;
+	};
+
+	// times a phase until it goes out of scope. Use PROFILE_SCOPE rather than making these directly
+	class Scope
+	{
+	public:
+		Scope(Profiler& profiler, Phase phase) : m_profiler(profiler), m_phase(phase), m_start(Clock::now()) {}
+		~Scope() { m_profiler.Add(m_phase, m_start, Clock::now()); }
+
+	private:
+		Profiler& m_profiler;
+		Phase m_phase;
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+	Profiler();
+
+	// call once a frame, after everything in it has been timed
+	void EndFrame();
+	Stats GetStats(int phase);
+	// a line per phase with its stats
+	void Print();
+	void Reset();
+
+	// starts recording events for a trace, throwing away any that were recorded before
+	void StartTrace();
+	// stops recording and writes what was recorded as Chrome trace JSON. Returns false if the file can't be written
+	bool WriteTrace(const char* path);
+	bool IsTracing() { return m_tracing; }
+
+	// recording stops after this many events, so leaving a trace running can't use up all the memory
+	int maxTraceEvents = 1 << 20;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Event
+	{
+		Phase phase;
+		int frame;
+		// microseconds since the trace started
+		double start, duration;
+	};
+
+	void Add(Phase phase, Clock::time_point start, Clock::time_point end);
+
+	// time spent in each phase so far this frame
+	double m_current[NUM_PHASES];
+	// a ring of per frame totals for each phase
+	std::vector<double> m_history[NUM_PHASES];
+	double m_total[NUM_PHASES];
+	int m_frame = 0;
+	int m_numFrames = 0;
+
+	bool m_tracing = false;
+	Clock::time_point m_traceStart;
+	std::vector<Event> m_events;
+	std::vector<double> m_sorted;
+};
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include <glm/glm/glm.hpp>
+#include <stdio.h>
+#include <string.h>
+
+#include "Replay.h"
+#include "PhysicsWorld.h"
+#include "RigidBody.h"
+#include "Scenes.h"
+#include "SceneFile.h"
+
+void Replay::Start(PhysicsWorld& world, const char* scene)
+{
+	header = {};
+	header.magic = MAGIC;
+	header.version = VERSION;
+	strncpy(header.scene, scene, sizeof(header.scene) - 1);
+	header.dt = world.dt;
+	header.substeps = world.substeps;
+	header.broadphase = world.m_broadphase->GetType();
+	header.velocityIterations = world.velocityIterations;
+	header.positionIterations = world.positionIterations;
+	header.timeToSleep = world.timeToSleep;
+
+	commands.clear();
+	hashes.clear();
+	m_input = 0;
+	world.recording = this;
+}
+
+void Replay::Stop(PhysicsWorld& world)
+{
+	if (world.recording == this)
+		world.recording = nullptr;
+	header.numCommands = (int)commands.size();
+	header.numSteps = (int)hashes.size();
+}
+
+Replay::Command& Replay::AddCommand(int type, int value)
+{
+	Command command = {};
+	command.step = (int)hashes.size();
+	command.type = type;
+	command.value = value;
+	commands.push_back(command);
+	return commands.back();
+}
+
+void Replay::RecordInput(unsigned int input)
+{
+	// input is held for many steps at a time, so only changes are kept
+	if (input == m_input)
+		return;
+	AddCommand(INPUT, (int)input);
+	m_input = input;
+}
+
+void Replay::RecordForce(int handle, glm::vec2 force, glm::vec2 point)
+{
+	Command& command = AddCommand(FORCE, handle);
+	command.force = force;
+	command.point = point;
+}
+
+void Replay::RecordBroadphase(int type)
+{
+	AddCommand(BROADPHASE, type);
+}
+
+void Replay::RecordStep(unsigned long long hash)
+{
+	hashes.push_back(hash);
+}
+
+bool Replay::Save(const char* path)
+{
+	FILE* file = fopen(path, "wb");
+	if (!file)
+		return false;
+
+	header.numCommands = (int)commands.size();
+	header.numSteps = (int)hashes.size();
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(commands.data(), sizeof(Command), commands.size(), file);
+	fwrite(hashes.data(), sizeof(unsigned long long), hashes.size(), file);
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+	return ok;
+}
+
+bool Replay::Load(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return false;
+
+	bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == MAGIC && header.version == VERSION &&
+		header.numCommands >= 0 && header.numSteps >= 0;
+	if (ok)
+	{
+		commands.resize(header.numCommands);
+		hashes.resize(header.numSteps);
+		ok = fread(commands.data(), sizeof(Command), commands.size(), file) == commands.size() &&
+			fread(hashes.data(), sizeof(unsigned long long), hashes.size(), file) == hashes.size();
+	}
+	fclose(file);
+
+	header.scene[sizeof(header.scene) - 1] = 0;
+	if (!ok)
+	{
+		commands.clear();
+		hashes.clear();
+	}
+	return ok;
+}
+
+bool Replay::Restart(PhysicsWorld& world)
+{
+	SceneFunction reset = FindScene(header.scene);
+	world.recording = nullptr;
+	world.Clear();
+
+	// a scene file sets the world up itself, so the recorded settings go on top
+	SceneFile scene;
+	if (!reset && !scene.Load(world, header.scene))
+		return false;
+
+	world.SetBroadphase((Broadphase::BroadphaseType)header.broadphase);
+	world.dt = header.dt;
+	world.substeps = header.substeps;
+	world.velocityIterations = header.velocityIterations;
+	world.positionIterations = header.positionIterations;
+	world.timeToSleep = header.timeToSleep;
+	world.input = 0;
+	if (reset)
+		reset(&world);
+
+	m_step = 0;
+	m_nextCommand = 0;
+	return true;
+}
+
+bool Replay::PlayStep(PhysicsWorld& world)
+{
+	for (; m_nextCommand < (int)commands.size() && commands[m_nextCommand].step <= m_step; m_nextCommand++)
+	{
+		const Command& command = commands[m_nextCommand];
+		switch (command.type)
+		{
+		case INPUT:
+			world.input = (unsigned int)command.value;
+			break;
+		case FORCE:
+			if (world.bodies.IsValid(command.value))
+				world.ApplyForce(world.bodies.body[world.bodies.Index(command.value)], command.force, command.point);
+			break;
+		case BROADPHASE:
+			world.SetBroadphase((Broadphase::BroadphaseType)command.value);
+			break;
+		}
+	}
+
+	world.Step();
+	bool match = m_step < (int)hashes.size() && world.StateHash() == hashes[m_step];
+	m_step++;
+	return match;
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+#include <vector>
+
+class PhysicsWorld;
+
+// a journal of everything from outside that changed a world while it ran, so the run can be played back exactly.
+// It starts from one of the named built in scenes or a scene file, and records the player input, pushes on bodies and broadphase
+// changes against the step they happened before, along with a hash of the world's state after every step.
+// Playing it back re-runs the steps headless, as fast as they go, checking each hash so the first step that
+// comes out differently is known.
+class Replay
+{
+public:
+	enum CommandType
+	{
+		// value is the new PhysicsWorld::input
+		INPUT,
+		// value is the body's handle. The force is applied at point
+		FORCE,
+		// value is the Broadphase::BroadphaseType switched to
+		BROADPHASE,
+	};
+
+	struct Command
+	{
+		// applied just before this step, counting from 0
+		int step;
+		int type;
+		int value;
+		glm::vec2 force;
+		glm::vec2 point;
+	};
+
+	// the world's settings when recording started
+	struct Header
+	{
+		unsigned int magic;
+		unsigned int version;
+		// a built in scene's name or a scene file's path
+		char scene[128];
+		float dt;
+		int substeps;
+		int broadphase;
+		int velocityIterations;
+		int positionIterations;
+		float timeToSleep;
+		int numCommands;
+		int numSteps;
+	};
+
+	enum { MAGIC = 0x4c505250, VERSION = 2 };
+
+	// starts recording world, which must have just been cleared and had the scene with this name (see FindScene())
+	// or from this file added to it, with no steps taken yet. The world records into this until Stop()
+	void Start(PhysicsWorld& world, const char* scene);
+	void Stop(PhysicsWorld& world);
+
+	// called by the world while it's being recorded
+	void RecordInput(unsigned int input);
+	void RecordForce(int handle, glm::vec2 force, glm::vec2 point);
+	void RecordBroadphase(int type);
+	void RecordStep(unsigned long long hash);
+
+	// a header, the commands, then a 64 bit hash per step. Both return false if the file can't be used
+	bool Save(const char* path);
+	bool Load(const char* path);
+
+	// clears the world and sets it up as it was when recording started. Returns false if the scene isn't known or won't load
+	bool Restart(PhysicsWorld& world);
+	// applies the commands for the next step, takes it, and returns whether the world's hash matches the recording
+	bool PlayStep(PhysicsWorld& world);
+	// how many steps have been played since Restart()
+	int StepsPlayed() { return m_step; }
+
+	int NumSteps() { return (int)hashes.size(); }
+
+	Header header = {};
+	std::vector<Command> commands;
+	std::vector<unsigned long long> hashes;
+
+private:
+	Command& AddCommand(int type, int value);
+
+	unsigned int m_input = 0;
+	int m_step = 0;
+	int m_nextCommand = 0;
+};
\ No newline at end of file
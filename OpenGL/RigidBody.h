@@ -1,37 +1,73 @@
 #pragma once
 #include "PhysicsObject.h"
+#include "Broadphase.h"
+#include "BodyStore.h"
 
+// a rigid body is a view onto one slot of its world's BodyStore. Until it's added to a world
+// its starting state is held in def, and the state accessors mustn't be used.
 class RigidBody : public PhysicsObject
 {
 public:
 	RigidBody();
+	virtual ~RigidBody();
 
-	virtual void Update(float dt);
+	// moves the body's state into the store
+	void Attach(BodyStore* bodyStore);
 
-	// force and pos are in world coordinates
+	// integration is done for all bodies at once by the world, so there's nothing to do per body
+	virtual void Update(float) {}
+	virtual bool HasUpdate() { return false; }
+
+	// force and pos are in world coordinates. Wakes the body, and everything it's resting on, if it's asleep
 	virtual void ApplyForce(glm::vec2 force, glm::vec2 pos);
 	void ApplyContactForce(float penetration, glm::vec2 normal);
 
-	virtual float getEnergy(float& k, float& g, float &r);
-
-	void ResolveCollision(RigidBody* other, glm::vec2 contact, glm::vec2* direction = NULL);
+	// adds a single point body to body manifold
+	void AddContact(std::vector<ContactManifold>& contacts, RigidBody* other, glm::vec2 contact, glm::vec2 normal, float separation, unsigned int id);
 
 	glm::vec2 ToWorld(glm::vec2 pos);
 
-	static glm::vec2 gravity;
+	// where to draw the body, in between the last two steps by the world's interpolation fraction
+	glm::vec2 DrawPosition();
+	float DrawAngle();
+	glm::vec2 DrawToWorld(glm::vec2 pos);
+
+	// world space bounds, used by the broadphase
+	virtual AABB GetAABB() = 0;
+
+	// intersects the line from start to end with the body, returning how far along the line the hit is
+	virtual bool RayCast(glm::vec2 start, glm::vec2 end, float& fraction) = 0;
+
+	// state held in the store
+	int Index() { return store->Index(handle); }
+	glm::vec2& Position() { return store->position[Index()]; }
+	glm::vec2& Velocity() { return store->velocity[Index()]; }
+	float& Angle() { return store->angle[Index()]; }
+	float& Rotation() { return store->rotation[Index()]; }
+	float& Restitution() { return store->restitution[Index()]; }
+	float InvMass() { return store->invMass[Index()]; }
+	float InvMoment() { return store->invMoment[Index()]; }
+	glm::vec2& LocalX() { return store->localX[Index()]; }
+	glm::vec2& LocalY() { return store->localY[Index()]; }
+
+	// fixed bodies are never awake. Use PhysicsWorld::Wake() to wake a body up
+	bool IsAwake() { return (store->flags[Index()] & BodyStore::AWAKE) != 0; }
+	bool IsFixed() { return (store->flags[Index()] & BodyStore::FIXED) != 0; }
+	bool IsBullet() { return (store->flags[Index()] & BodyStore::BULLET) != 0; }
+	void SetBullet(bool bullet) { SetFlag(BodyStore::BULLET, bullet); }
 
-	glm::vec2 position;
-	glm::vec2 velocity;
-	float angle;
-	float rotation;
-	float mass;
-	float moment;
+	BodyDef def;
 
-	float restitution;
+	BodyStore* store = nullptr;
+	int handle = -1;
 
-	bool awake;
-	bool fixed;
-	bool hasContact = false;
+	// the broadphase's handle for this body
+	int proxy = -1;
 
-	glm::vec2 localX, localY;
+private:
+	void SetFlag(unsigned char flag, bool on)
+	{
+		unsigned char& flags = store->flags[Index()];
+		flags = on ? (flags | flag) : (flags & ~flag);
+	}
 };
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include <chrono>
+
+#include "Rollouts.h"
+#include "PhysicsWorld.h"
+#include "JobSystem.h"
+
+Rollouts::~Rollouts()
+{
+	for (auto world : m_worlds)
+		delete world;
+	delete m_jobs;
+}
+
+void Rollouts::Start(PhysicsWorld& world)
+{
+	m_start.Capture(world);
+	m_instructionSet = world.instructionSet;
+}
+
+bool Rollouts::Run(int count, int numSteps, const std::function<void(PhysicsWorld&, int)>& vary,
+	const std::function<float(PhysicsWorld&, int)>& measure)
+{
+	if (m_start.Size() == 0)
+		return false;
+
+	if (!m_jobs || m_jobThreads != numThreads)
+	{
+		delete m_jobs;
+		m_jobs = new JobSystem(numThreads);
+		m_jobThreads = numThreads;
+	}
+
+	for (int i = count; i < (int)m_worlds.size(); i++)
+		delete m_worlds[i];
+	m_worlds.resize(count, nullptr);
+	results.resize(count);
+
+	m_jobs->ParallelFor(count, [&](int i)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		// made on the thread that runs it, so the copies are built in parallel too
+		PhysicsWorld*& world = m_worlds[i];
+		if (!world)
+			world = new PhysicsWorld();
+		// the rollouts are already spread over the threads, so each world keeps to its own
+		world->numThreads = 1;
+		world->instructionSet = m_instructionSet;
+		m_start.Restore(*world);
+
+		if (vary)
+			vary(*world, i);
+		for (int step = 0; step < numSteps; step++)
+			world->Step();
+
+		Result& result = results[i];
+		float k, g, r;
+		result.steps = numSteps;
+		result.hash = world->StateHash();
+		result.energy = world->getEnergy(k, g, r);
+		result.value = measure ? measure(*world, i) : 0;
+		result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	});
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+#include "Integrator.h"
+#include "Snapshot.h"
+
+class JobSystem;
+class PhysicsWorld;
+
+// runs many copies of one world side by side, each changed a little before it's stepped, for sweeping a setting
+// such as restitution, spring stiffness or a launch velocity over the same scene. Every rollout starts from the
+// same snapshot, and rollouts share nothing while they run, so rollout i comes out the same whatever the thread
+// count and however many others run alongside it.
+//
+// The copies are kept between calls to Run(). While nothing adds or removes objects they're restored in place,
+// so a sweep run again and again only copies arrays.
+class Rollouts
+{
+public:
+	struct Result
+	{
+		int steps;
+		// of the rollout's world once it's finished, as PhysicsWorld::StateHash()
+		unsigned long long hash;
+		float energy;
+		// whatever the measure passed to Run() made of the world, or 0 if there wasn't one
+		float value;
+		double ms;
+	};
+
+	~Rollouts();
+
+	// takes the state every rollout starts from. The world isn't held on to, so it can carry on or be changed
+	void Start(PhysicsWorld& world);
+
+	// restores count copies, calls vary(world, i) on the ith before stepping it numSteps times, then
+	// measure(world, i) to fill in its result. Both are called on whichever thread runs the rollout, so they
+	// mustn't share anything they write to. Returns false if Start() hasn't been called
+	bool Run(int count, int numSteps, const std::function<void(PhysicsWorld&, int)>& vary,
+		const std::function<float(PhysicsWorld&, int)>& measure = nullptr);
+
+	// the ith rollout's world as Run() left it
+	PhysicsWorld& World(int i) { return *m_worlds[i]; }
+
+	// threads the rollouts are shared between, 0 for one per core. Each rollout steps its world on one thread
+	int numThreads = 0;
+
+	// one for each rollout from the last Run()
+	std::vector<Result> results;
+
+private:
+	Snapshot m_start;
+	Integrator::InstructionSet m_instructionSet = Integrator::Best();
+
+	std::vector<PhysicsWorld*> m_worlds;
+
+	JobSystem* m_jobs = nullptr;
+	int m_jobThreads = 0;
+};
\ No newline at end of file
@@ -0,0 +1,123 @@
+// scene_convert: compiles text scenes into the binary form and turns them back, or writes out one of the scenes
+// built in code. Built by scene_convert.vcxproj, not the main project.
+//
+//   scene_convert in out
+//   scene_convert -scene name out      one of the built in scenes: pool, lander, springs, basic or twoboxes
+//   scene_convert -rain n out          n circles raining into a tray, for trying out big scenes
+//
+// Files ending in .scene are written as text, anything else in the binary form. Either form can be read.
+
+#include <glm/glm/glm.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "PhysicsWorld.h"
+#include "SceneFile.h"
+#include "Scenes.h"
+
+// records passed across at a time
+static const int BATCH_SIZE = 1024;
+
+static bool IsTextPath(const char* path)
+{
+	size_t length = strlen(path);
+	return length >= 6 && !strcmp(path + length - 6, ".scene");
+}
+
+static void Usage()
+{
+	fprintf(stderr, "scene_convert in out\n");
+	fprintf(stderr, "scene_convert -scene pool|lander|springs|basic|twoboxes out\n");
+	fprintf(stderr, "scene_convert -rain n out\n");
+	fprintf(stderr, "out is written as text if it ends in .scene, otherwise in the binary form\n");
+}
+
+// streams the records straight across, so the scene is never held in memory
+static int Convert(const char* inPath, const char* outPath)
+{
+	SceneFile in;
+	if (!in.Open(inPath))
+	{
+		fprintf(stderr, "%s: %s\n", inPath, in.Error());
+		return 1;
+	}
+
+	SceneFile out;
+	if (!out.Create(outPath, !IsTextPath(outPath), in.settings))
+	{
+		fprintf(stderr, "%s\n", out.Error());
+		return 1;
+	}
+
+	static SceneFile::Record records[BATCH_SIZE];
+	int count;
+	do
+	{
+		count = in.Read(records, BATCH_SIZE);
+		for (int i = 0; i < count; i++)
+			out.Write(records[i]);
+	} while (count == BATCH_SIZE);
+
+	if (!in.Close())
+	{
+		fprintf(stderr, "%s: %s\n", inPath, in.Error());
+		return 1;
+	}
+	if (!out.Close())
+	{
+		fprintf(stderr, "%s: %s\n", outPath, out.Error());
+		return 1;
+	}
+	fprintf(stderr, "%s: %d objects, %d of them bodies\n", outPath, out.numRecords, out.numBodies);
+	return 0;
+}
+
+// builds the scene in a world and saves that
+static int Export(PhysicsWorld& world, const char* outPath)
+{
+	SceneFile out;
+	if (!out.Save(world, outPath, !IsTextPath(outPath)))
+	{
+		fprintf(stderr, "%s: %s\n", outPath, out.Error());
+		return 1;
+	}
+	fprintf(stderr, "%s: %d objects, %d of them bodies\n", outPath, out.numRecords, out.numBodies);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc == 3 && argv[1][0] != '-')
+		return Convert(argv[1], argv[2]);
+
+	if (argc != 4)
+	{
+		Usage();
+		return 1;
+	}
+
+	PhysicsWorld world;
+	if (!strcmp(argv[1], "-scene"))
+	{
+		SceneFunction reset = FindScene(argv[2]);
+		if (!reset)
+		{
+			fprintf(stderr, "no scene called %s\n", argv[2]);
+			return 1;
+		}
+		reset(&world);
+	}
+	else if (!strcmp(argv[1], "-rain") && atoi(argv[2]) > 0)
+	{
+		// bodies go into the spatial hash in constant time, so it loads by far the quickest
+		world.SetBroadphase(Broadphase::SPATIAL_HASH);
+		ResetRain(&world, atoi(argv[2]));
+	}
+	else
+	{
+		Usage();
+		return 1;
+	}
+	return Export(world, argv[3]);
+}
\ No newline at end of file
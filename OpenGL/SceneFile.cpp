@@ -0,0 +1,818 @@
+#include <glm/glm/glm.hpp>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "SceneFile.h"
+#include "PhysicsWorld.h"
+#include "Plane.h"
+#include "Circle.h"
+#include "Box.h"
+#include "Spring.h"
+#include "LunarLander.h"
+
+// records built into the world at a time while loading
+static const int LOAD_BATCH = 256;
+
+// opaque red, as objects start out
+static const unsigned int DEFAULT_COLOR = 0xff0000ff;
+static const float DEFAULT_RESTITUTION = 0.95f;
+
+// where things are in Record::values
+enum
+{
+	BODY_X,
+	BODY_Y,
+	BODY_VX,
+	BODY_VY,
+	BODY_ANGLE,
+	BODY_ROTATION,
+	BODY_INV_MASS,
+	BODY_INV_MOMENT,
+	BODY_RESTITUTION,
+	BODY_RADIUS,
+	BODY_WIDTH = BODY_RADIUS,
+	BODY_HEIGHT,
+
+	PLANE_ORIGIN = 0,
+	PLANE_NORMAL = 2,
+
+	SPRING_REST_LENGTH = 0,
+	SPRING_RESTORING_FORCE,
+	SPRING_ANCHORS,
+};
+
+static const char* s_kindNames[] = { "plane", "circle", "box", "lander", "spring" };
+static const char* s_broadphaseNames[] = { "brute_force", "spatial_hash", "sweep_and_prune", "aabb_tree" };
+
+static bool IsBody(int kind)
+{
+	return kind == SceneFile::CIRCLE || kind == SceneFile::BOX || kind == SceneFile::LANDER;
+}
+
+static bool IsSetting(const char* word)
+{
+	static const char* settings[] = { "gravity", "dt", "substeps", "iterations", "sleep", "broadphase" };
+	for (auto setting : settings)
+	{
+		if (!strcmp(word, setting))
+			return true;
+	}
+	return false;
+}
+
+static unsigned int PackColor(glm::vec4 color)
+{
+	unsigned int packed = 0;
+	for (int i = 0; i < 4; i++)
+		packed |= (unsigned int)(glm::clamp(color[i], 0.0f, 1.0f) * 255 + 0.5f) << (8 * i);
+	return packed;
+}
+
+static glm::vec4 UnpackColor(unsigned int packed)
+{
+	glm::vec4 color;
+	for (int i = 0; i < 4; i++)
+		color[i] = ((packed >> (8 * i)) & 255) / 255.0f;
+	return color;
+}
+
+// the inverse mass and moment a body of this density gets, worked out by the body's own constructor so they come
+// out exactly as they would for one made in code
+static void InverseMass(const SceneFile::Record& record, float density, float& invMass, float& invMoment)
+{
+	const float* values = record.values;
+	BodyDef def;
+	if (record.kind == SceneFile::CIRCLE)
+		def = Circle(glm::vec2(0, 0), glm::vec2(0, 0), values[BODY_RADIUS], 0, density).def;
+	else if (record.kind == SceneFile::BOX)
+		def = Box(glm::vec2(0, 0), glm::vec2(0, 0), 0, values[BODY_WIDTH], values[BODY_HEIGHT], density).def;
+	else
+		def = LunarLander(glm::vec2(0, 0)).def;
+
+	bool fixed = (record.flags & SceneFile::FIXED) != 0;
+	invMass = fixed ? 0 : 1.0f / def.mass;
+	invMoment = fixed ? 0 : 1.0f / def.moment;
+}
+
+// the world's bodies were all added to it after it was cleared, so their handles are just their numbers
+static RigidBody* FindBody(PhysicsWorld& world, int number)
+{
+	return world.bodies.body[world.bodies.Index(number)];
+}
+
+static void AddRecord(PhysicsWorld& world, const SceneFile::Record& record)
+{
+	const float* values = record.values;
+	glm::vec2 position(values[BODY_X], values[BODY_Y]);
+	glm::vec2 velocity(values[BODY_VX], values[BODY_VY]);
+	bool fixed = (record.flags & SceneFile::FIXED) != 0;
+
+	PhysicsObject* obj;
+	RigidBody* body = nullptr;
+	switch (record.kind)
+	{
+	case SceneFile::PLANE:
+	{
+		Plane* plane = new Plane(glm::vec2(values[PLANE_ORIGIN], values[PLANE_ORIGIN + 1]), glm::vec2(values[PLANE_NORMAL], values[PLANE_NORMAL + 1]));
+		plane->oneSided = (record.flags & SceneFile::TWO_SIDED) == 0;
+		obj = plane;
+		break;
+	}
+	case SceneFile::CIRCLE:
+		obj = body = world.NewCircle(position, velocity, values[BODY_RADIUS], 1);
+		break;
+	case SceneFile::BOX:
+		obj = body = world.NewBox(position, velocity, values[BODY_ANGLE], values[BODY_WIDTH], values[BODY_HEIGHT], 1, fixed);
+		break;
+	case SceneFile::LANDER:
+	{
+		LunarLander* lander = new LunarLander(position);
+		lander->def.velocity = velocity;
+		lander->radius = values[BODY_RADIUS];
+		obj = body = lander;
+		break;
+	}
+	default:
+		obj = world.NewSpring(FindBody(world, record.body1), FindBody(world, record.body2),
+			values[SPRING_REST_LENGTH], values[SPRING_RESTORING_FORCE],
+			glm::vec2(values[SPRING_ANCHORS], values[SPRING_ANCHORS + 1]), glm::vec2(values[SPRING_ANCHORS + 2], values[SPRING_ANCHORS + 3]));
+		break;
+	}
+	obj->color = UnpackColor(record.color);
+
+	if (body)
+	{
+		body->def.angle = values[BODY_ANGLE];
+		body->def.rotation = values[BODY_ROTATION];
+		body->def.restitution = values[BODY_RESTITUTION];
+		body->def.fixed = fixed;
+		body->def.bullet = (record.flags & SceneFile::BULLET) != 0;
+		body->def.awake = (record.flags & SceneFile::ASLEEP) == 0;
+	}
+	world.AddObject(obj);
+
+	// set directly rather than through the def, as inverting the mass twice could come out a bit different
+	if (body)
+	{
+		int index = body->Index();
+		world.bodies.invMass[index] = values[BODY_INV_MASS];
+		world.bodies.invMoment[index] = values[BODY_INV_MOMENT];
+	}
+}
+
+SceneFile::~SceneFile()
+{
+	if (m_file)
+		fclose(m_file);
+}
+
+// closes anything that's open and starts afresh
+void SceneFile::Reset()
+{
+	if (m_file)
+		fclose(m_file);
+	m_file = nullptr;
+	m_binary = false;
+	m_writing = false;
+	m_failed = false;
+	m_error[0] = 0;
+	m_records = 0;
+	m_bodies = 0;
+	m_numWords = 0;
+	m_word = 0;
+	m_lineNumber = 0;
+	m_pending = false;
+	settings = Settings();
+	numRecords = 0;
+	numBodies = 0;
+}
+
+bool SceneFile::Load(PhysicsWorld& world, const char* path)
+{
+	if (!Open(path))
+		return false;
+
+	world.Clear();
+	world.gravity = settings.gravity;
+	world.dt = settings.dt;
+	world.substeps = settings.substeps;
+	world.velocityIterations = settings.velocityIterations;
+	world.positionIterations = settings.positionIterations;
+	world.timeToSleep = settings.timeToSleep;
+	world.SetBroadphase((Broadphase::BroadphaseType)settings.broadphase);
+
+	// binary files say how big they are up front, so there's room made for everything at once
+	world.bodies.Reserve(numBodies);
+	world.m_physicsObjects.reserve(numRecords);
+
+	Record records[LOAD_BATCH];
+	int count;
+	do
+	{
+		count = Read(records, LOAD_BATCH);
+		for (int i = 0; i < count; i++)
+			AddRecord(world, records[i]);
+	} while (count == LOAD_BATCH);
+
+	return Close();
+}
+
+bool SceneFile::Save(PhysicsWorld& world, const char* path, bool binary)
+{
+	Settings worldSettings;
+	worldSettings.gravity = world.gravity;
+	worldSettings.dt = world.dt;
+	worldSettings.substeps = world.substeps;
+	worldSettings.velocityIterations = world.velocityIterations;
+	worldSettings.positionIterations = world.positionIterations;
+	worldSettings.timeToSleep = world.timeToSleep;
+	worldSettings.broadphase = world.m_broadphase->GetType();
+	if (!Create(path, binary, worldSettings))
+		return false;
+
+	// each body's number in the file, by handle, for the springs
+	int maxHandle = -1;
+	for (int handle : world.bodies.handle)
+		maxHandle = std::max(maxHandle, handle);
+	std::vector<int> numbers(maxHandle + 1, -1);
+
+	for (auto obj : world.m_physicsObjects)
+	{
+		Record record = {};
+		record.color = PackColor(obj->color);
+		record.body1 = -1;
+		record.body2 = -1;
+		float* values = record.values;
+
+		RigidBody* body = nullptr;
+		switch (obj->oType)
+		{
+		case PhysicsObject::PLANE:
+		{
+			Plane* plane = (Plane*)obj;
+			record.kind = PLANE;
+			record.flags = plane->oneSided ? 0 : TWO_SIDED;
+			values[PLANE_ORIGIN] = plane->origin.x;
+			values[PLANE_ORIGIN + 1] = plane->origin.y;
+			values[PLANE_NORMAL] = plane->normal.x;
+			values[PLANE_NORMAL + 1] = plane->normal.y;
+			break;
+		}
+		case PhysicsObject::CIRCLE:
+			record.kind = dynamic_cast<LunarLander*>(obj) ? LANDER : CIRCLE;
+			values[BODY_RADIUS] = ((Circle*)obj)->radius;
+			body = (RigidBody*)obj;
+			break;
+		case PhysicsObject::BOX:
+			record.kind = BOX;
+			values[BODY_WIDTH] = ((Box*)obj)->width;
+			values[BODY_HEIGHT] = ((Box*)obj)->height;
+			body = (RigidBody*)obj;
+			break;
+		case PhysicsObject::SPRING:
+		{
+			Spring* spring = (Spring*)obj;
+			record.kind = SPRING;
+			record.body1 = numbers[spring->body1->handle];
+			record.body2 = numbers[spring->body2->handle];
+			values[SPRING_REST_LENGTH] = spring->restLength;
+			values[SPRING_RESTORING_FORCE] = spring->restoringForce;
+			values[SPRING_ANCHORS] = spring->contact1.x;
+			values[SPRING_ANCHORS + 1] = spring->contact1.y;
+			values[SPRING_ANCHORS + 2] = spring->contact2.x;
+			values[SPRING_ANCHORS + 3] = spring->contact2.y;
+			break;
+		}
+		}
+
+		if (body)
+		{
+			int index = body->Index();
+			BodyStore& bodies = world.bodies;
+			numbers[body->handle] = m_bodies;
+			values[BODY_X] = bodies.position[index].x;
+			values[BODY_Y] = bodies.position[index].y;
+			values[BODY_VX] = bodies.velocity[index].x;
+			values[BODY_VY] = bodies.velocity[index].y;
+			values[BODY_ANGLE] = bodies.angle[index];
+			values[BODY_ROTATION] = bodies.rotation[index];
+			values[BODY_INV_MASS] = bodies.invMass[index];
+			values[BODY_INV_MOMENT] = bodies.invMoment[index];
+			values[BODY_RESTITUTION] = bodies.restitution[index];
+			record.flags = (body->IsFixed() ? FIXED : 0) | (body->IsBullet() ? BULLET : 0) |
+				(!body->IsFixed() && !body->IsAwake() ? ASLEEP : 0);
+		}
+
+		Write(record);
+	}
+	return Close();
+}
+
+bool SceneFile::Open(const char* path)
+{
+	Reset();
+	m_file = fopen(path, "rb");
+	if (!m_file)
+		return Fail("couldn't open %s", path);
+
+	unsigned int magic = 0;
+	m_binary = fread(&magic, sizeof(magic), 1, m_file) == 1 && magic == MAGIC;
+	rewind(m_file);
+
+	if (m_binary)
+	{
+		Header header;
+		if (fread(&header, sizeof(header), 1, m_file) != 1 || header.version != VERSION ||
+			header.numRecords < 0 || header.numBodies < 0 || header.numBodies > header.numRecords)
+			return Fail("%s isn't a scene this version can read", path);
+		if (!Check(header.settings))
+			return false;
+		settings = header.settings;
+		numRecords = header.numRecords;
+		numBodies = header.numBodies;
+		return true;
+	}
+
+	// the settings come first, so read up to the first object and leave it for Read()
+	while (ReadLine())
+	{
+		if (!IsSetting(m_words[0]))
+		{
+			m_pending = true;
+			return true;
+		}
+		if (!ParseSetting())
+			return false;
+	}
+	return !m_failed;
+}
+
+int SceneFile::Read(Record* records, int max)
+{
+	if (!m_file || m_writing || m_failed)
+		return 0;
+
+	int count = 0;
+	if (m_binary)
+	{
+		int wanted = std::min(max, numRecords - m_records);
+		count = (int)fread(records, sizeof(Record), wanted, m_file);
+		for (int i = 0; i < count; i++)
+		{
+			if (!Check(records[i]))
+				return i;
+		}
+		if (count < wanted)
+			Fail("the file stops after %d of its %d records", m_records, numRecords);
+	}
+	else
+	{
+		while (count < max && ReadText(records[count]))
+			count++;
+	}
+	return count;
+}
+
+bool SceneFile::Create(const char* path, bool binary, const Settings& fileSettings)
+{
+	Reset();
+	if (!Check(fileSettings))
+		return false;
+	m_file = fopen(path, binary ? "wb" : "w");
+	if (!m_file)
+		return Fail("couldn't create %s", path);
+
+	m_writing = true;
+	m_binary = binary;
+	settings = fileSettings;
+
+	if (binary)
+	{
+		// the counts are filled in by Close()
+		Header header;
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.settings = settings;
+		header.numRecords = 0;
+		header.numBodies = 0;
+		fwrite(&header, sizeof(header), 1, m_file);
+	}
+	else
+	{
+		fprintf(m_file, "gravity %.9g %.9g\n", settings.gravity.x, settings.gravity.y);
+		fprintf(m_file, "dt %.9g\n", settings.dt);
+		fprintf(m_file, "substeps %d\n", settings.substeps);
+		fprintf(m_file, "iterations %d %d\n", settings.velocityIterations, settings.positionIterations);
+		fprintf(m_file, "sleep %.9g\n", settings.timeToSleep);
+		fprintf(m_file, "broadphase %s\n\n", s_broadphaseNames[settings.broadphase]);
+	}
+	return true;
+}
+
+void SceneFile::Write(const Record& record)
+{
+	if (!m_file || !m_writing || m_failed || !Check(record))
+		return;
+
+	if (m_binary)
+		fwrite(&record, sizeof(record), 1, m_file);
+	else
+		WriteText(record);
+}
+
+bool SceneFile::Close()
+{
+	if (!m_file)
+		return !m_failed;
+
+	if (m_writing && m_binary)
+	{
+		Header header;
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.settings = settings;
+		header.numRecords = m_records;
+		header.numBodies = m_bodies;
+		fseek(m_file, 0, SEEK_SET);
+		fwrite(&header, sizeof(header), 1, m_file);
+	}
+	if (ferror(m_file) && !m_failed)
+		Fail(m_writing ? "couldn't write the whole file" : "couldn't read the whole file");
+
+	fclose(m_file);
+	m_file = nullptr;
+	return !m_failed;
+}
+
+// makes sure a world can be set up with these
+bool SceneFile::Check(const Settings& fileSettings)
+{
+	if (fileSettings.broadphase < Broadphase::BRUTE_FORCE || fileSettings.broadphase > Broadphase::AABB_TREE)
+		return Fail("there's no broadphase number %d", fileSettings.broadphase);
+	if (!isfinite(fileSettings.gravity.x) || !isfinite(fileSettings.gravity.y) || !isfinite(fileSettings.timeToSleep))
+		return Fail("the settings have a number that's too big or isn't a number");
+	if (!isfinite(fileSettings.dt) || fileSettings.dt <= 0)
+		return Fail("dt has to be more than 0, not %g", fileSettings.dt);
+	if (fileSettings.substeps < 1)
+		return Fail("there has to be at least 1 substep, not %d", fileSettings.substeps);
+	return true;
+}
+
+// makes sure the record can be built, and counts it
+bool SceneFile::Check(const Record& record)
+{
+	if (record.kind >= NUM_KINDS)
+		return Fail("record %d is of an unknown kind", m_records);
+	if (record.kind == SPRING && (record.body1 < 0 || record.body1 >= m_bodies || record.body2 < 0 || record.body2 >= m_bodies))
+		return Fail("record %d is a spring joining bodies %d and %d, but there are only %d bodies before it", m_records, record.body1, record.body2, m_bodies);
+	if (record.kind == SPRING && record.body1 == record.body2)
+		return Fail("record %d is a spring joining body %d to itself", m_records, record.body1);
+
+	// the same checks for text and binary files, so whatever loads can be stepped. The shapes go first, as a
+	// shape with no size has an infinite inverse mass
+	const float* values = record.values;
+	if (record.kind == PLANE && values[PLANE_NORMAL] == 0 && values[PLANE_NORMAL + 1] == 0)
+		return Fail("record %d is a plane with no normal", m_records);
+	if ((record.kind == CIRCLE || record.kind == LANDER) && values[BODY_RADIUS] <= 0)
+		return Fail("record %d is a %s with a radius of %g", m_records, s_kindNames[record.kind], values[BODY_RADIUS]);
+	if (record.kind == BOX && (values[BODY_WIDTH] <= 0 || values[BODY_HEIGHT] <= 0))
+		return Fail("record %d is a box %g wide and %g high", m_records, values[BODY_WIDTH], values[BODY_HEIGHT]);
+	for (int i = 0; i < (int)(sizeof(record.values) / sizeof(record.values[0])); i++)
+	{
+		if (!isfinite(values[i]))
+			return Fail("record %d has a number that's too big or isn't a number", m_records);
+	}
+
+	m_records++;
+	if (IsBody(record.kind))
+		m_bodies++;
+	if (m_writing || !m_binary)
+	{
+		numRecords = m_records;
+		numBodies = m_bodies;
+	}
+	return true;
+}
+
+bool SceneFile::ReadText(Record& record)
+{
+	if (!m_pending && !ReadLine())
+		return false;
+	m_pending = false;
+
+	if (IsSetting(m_words[0]))
+		return Fail("%s has to come before any objects", m_words[0]);
+	return ParseRecord(record) && Check(record);
+}
+
+// the next line with anything on it, split into words
+bool SceneFile::ReadLine()
+{
+	while (fgets(m_line, MAX_LINE, m_file))
+	{
+		m_lineNumber++;
+		if (!strchr(m_line, '\n') && !feof(m_file))
+			return Fail("line is longer than %d characters", MAX_LINE - 2);
+
+		m_numWords = 0;
+		m_word = 0;
+		char* c = m_line;
+		while (true)
+		{
+			while (*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n')
+				c++;
+			if (!*c || *c == '#')
+				break;
+			if (m_numWords == MAX_WORDS)
+				return Fail("more than %d words on a line", MAX_WORDS);
+			m_words[m_numWords++] = c;
+			while (*c && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n' && *c != '#')
+				c++;
+			if (*c == '#')
+			{
+				*c = 0;
+				break;
+			}
+			if (*c)
+				*c++ = 0;
+		}
+		if (m_numWords > 0)
+			return true;
+	}
+	return false;
+}
+
+bool SceneFile::ParseSetting()
+{
+	const char* setting = m_words[m_word++];
+	float values[2];
+	bool ok = true;
+	if (!strcmp(setting, "gravity"))
+	{
+		ok = ParseNumbers(values, 2);
+		if (ok)
+			settings.gravity = glm::vec2(values[0], values[1]);
+	}
+	else if (!strcmp(setting, "dt"))
+		ok = ParseNumbers(&settings.dt, 1);
+	else if (!strcmp(setting, "substeps"))
+	{
+		ok = ParseNumbers(values, 1);
+		if (ok)
+			settings.substeps = (int)values[0];
+	}
+	else if (!strcmp(setting, "iterations"))
+	{
+		ok = ParseNumbers(values, 2);
+		if (ok)
+		{
+			settings.velocityIterations = (int)values[0];
+			settings.positionIterations = (int)values[1];
+		}
+	}
+	else if (!strcmp(setting, "sleep"))
+		ok = ParseNumbers(&settings.timeToSleep, 1);
+	else
+	{
+		const char* name = m_word < m_numWords ? m_words[m_word++] : "";
+		int type = 0;
+		while (type < 4 && strcmp(name, s_broadphaseNames[type]))
+			type++;
+		if (type == 4)
+			return Fail("there's no broadphase called %s", name);
+		settings.broadphase = type;
+	}
+
+	if (ok && m_word < m_numWords)
+		return Fail("%s has something extra after it: %s", setting, m_words[m_word]);
+	// checked as each is read, so a bad one is reported against its own line
+	return ok && Check(settings);
+}
+
+bool SceneFile::ParseRecord(Record& record)
+{
+	const char* name = m_words[m_word++];
+	int kind = 0;
+	while (kind < NUM_KINDS && strcmp(name, s_kindNames[kind]))
+		kind++;
+	if (kind == NUM_KINDS)
+		return Fail("there's no such thing as a %s", name);
+
+	record = {};
+	record.kind = (unsigned short)kind;
+	record.color = DEFAULT_COLOR;
+	record.body1 = -1;
+	record.body2 = -1;
+	float* values = record.values;
+
+	bool ok;
+	switch (kind)
+	{
+	case PLANE:
+		ok = ParseNumbers(values + PLANE_ORIGIN, 4);
+		break;
+	case CIRCLE:
+		ok = ParseNumbers(values + BODY_X, 2) && ParseNumbers(values + BODY_RADIUS, 1);
+		break;
+	case BOX:
+		ok = ParseNumbers(values + BODY_X, 2) && ParseNumbers(values + BODY_WIDTH, 2);
+		break;
+	case LANDER:
+		ok = ParseNumbers(values + BODY_X, 2);
+		values[BODY_RADIUS] = LunarLander(glm::vec2(0, 0)).radius;
+		break;
+	default:
+	{
+		float bodies[2];
+		ok = ParseNumbers(bodies, 2) && ParseNumbers(values + SPRING_REST_LENGTH, 2);
+		if (ok)
+		{
+			record.body1 = (int)bodies[0];
+			record.body2 = (int)bodies[1];
+		}
+		break;
+	}
+	}
+	if (IsBody(kind))
+		values[BODY_RESTITUTION] = DEFAULT_RESTITUTION;
+
+	return ok && ParseOptions(record);
+}
+
+bool SceneFile::ParseOptions(Record& record)
+{
+	int kind = record.kind;
+	bool body = IsBody(kind);
+	float* values = record.values;
+	float density = 1;
+	bool massSet = false;
+	bool momentSet = false;
+
+	while (m_word < m_numWords)
+	{
+		const char* option = m_words[m_word++];
+		bool ok = true;
+		if (!strcmp(option, "color"))
+		{
+			float color[4];
+			ok = ParseNumbers(color, 4);
+			if (ok)
+				record.color = PackColor(glm::vec4(color[0], color[1], color[2], color[3]));
+		}
+		else if (kind == PLANE && !strcmp(option, "two_sided"))
+			record.flags |= TWO_SIDED;
+		else if (kind == SPRING && !strcmp(option, "anchors"))
+			ok = ParseNumbers(values + SPRING_ANCHORS, 4);
+		else if (body && !strcmp(option, "velocity"))
+			ok = ParseNumbers(values + BODY_VX, 2);
+		else if (body && !strcmp(option, "angle"))
+			ok = ParseNumbers(values + BODY_ANGLE, 1);
+		else if (body && !strcmp(option, "rotation"))
+			ok = ParseNumbers(values + BODY_ROTATION, 1);
+		else if (body && !strcmp(option, "restitution"))
+			ok = ParseNumbers(values + BODY_RESTITUTION, 1);
+		else if (body && !strcmp(option, "density"))
+			ok = ParseNumbers(&density, 1);
+		else if (body && !strcmp(option, "inv_mass"))
+			ok = massSet = ParseNumbers(values + BODY_INV_MASS, 1);
+		else if (body && !strcmp(option, "inv_moment"))
+			ok = momentSet = ParseNumbers(values + BODY_INV_MOMENT, 1);
+		else if (body && !strcmp(option, "fixed"))
+			record.flags |= FIXED;
+		else if (body && !strcmp(option, "bullet"))
+			record.flags |= BULLET;
+		else if (body && !strcmp(option, "asleep"))
+			record.flags |= ASLEEP;
+		else
+			return Fail("a %s can't have %s", s_kindNames[kind], option);
+
+		if (!ok)
+			return false;
+	}
+
+	if (body)
+	{
+		float invMass, invMoment;
+		InverseMass(record, density, invMass, invMoment);
+		bool fixed = (record.flags & FIXED) != 0;
+		if (!massSet || fixed)
+			values[BODY_INV_MASS] = invMass;
+		if (!momentSet || fixed)
+			values[BODY_INV_MOMENT] = invMoment;
+	}
+	return true;
+}
+
+bool SceneFile::ParseNumbers(float* values, int count)
+{
+	const char* name = m_words[0];
+	for (int i = 0; i < count; i++)
+	{
+		if (m_word == m_numWords)
+			return Fail("%s is missing some numbers", name);
+
+		const char* word = m_words[m_word++];
+		char* end;
+		values[i] = strtof(word, &end);
+		if (*end || end == word)
+			return Fail("%s should be a number", word);
+	}
+	return true;
+}
+
+void SceneFile::WriteText(const Record& record)
+{
+	const float* values = record.values;
+	switch (record.kind)
+	{
+	case PLANE:
+		fprintf(m_file, "plane %.9g %.9g %.9g %.9g", values[PLANE_ORIGIN], values[PLANE_ORIGIN + 1], values[PLANE_NORMAL], values[PLANE_NORMAL + 1]);
+		if (record.flags & TWO_SIDED)
+			fprintf(m_file, " two_sided");
+		break;
+	case CIRCLE:
+		fprintf(m_file, "circle %.9g %.9g %.9g", values[BODY_X], values[BODY_Y], values[BODY_RADIUS]);
+		break;
+	case BOX:
+		fprintf(m_file, "box %.9g %.9g %.9g %.9g", values[BODY_X], values[BODY_Y], values[BODY_WIDTH], values[BODY_HEIGHT]);
+		break;
+	case LANDER:
+		fprintf(m_file, "lander %.9g %.9g", values[BODY_X], values[BODY_Y]);
+		break;
+	default:
+		fprintf(m_file, "spring %d %d %.9g %.9g", record.body1, record.body2, values[SPRING_REST_LENGTH], values[SPRING_RESTORING_FORCE]);
+		if (values[SPRING_ANCHORS] != 0 || values[SPRING_ANCHORS + 1] != 0 || values[SPRING_ANCHORS + 2] != 0 || values[SPRING_ANCHORS + 3] != 0)
+		{
+			fprintf(m_file, " anchors %.9g %.9g %.9g %.9g",
+				values[SPRING_ANCHORS], values[SPRING_ANCHORS + 1], values[SPRING_ANCHORS + 2], values[SPRING_ANCHORS + 3]);
+		}
+		break;
+	}
+
+	if (IsBody(record.kind))
+	{
+		if (values[BODY_VX] != 0 || values[BODY_VY] != 0)
+			fprintf(m_file, " velocity %.9g %.9g", values[BODY_VX], values[BODY_VY]);
+		if (values[BODY_ANGLE] != 0)
+			fprintf(m_file, " angle %.9g", values[BODY_ANGLE]);
+		if (values[BODY_ROTATION] != 0)
+			fprintf(m_file, " rotation %.9g", values[BODY_ROTATION]);
+
+		if (!(record.flags & FIXED))
+		{
+			// a density if there's one that gives exactly these masses, as there is for anything that started out
+			// with one, otherwise the masses themselves
+			float density = 1;
+			float invMass, invMoment;
+			if (record.kind != LANDER)
+			{
+				InverseMass(record, 1, invMass, invMoment);
+				density = invMass / values[BODY_INV_MASS];
+			}
+			InverseMass(record, density, invMass, invMoment);
+			if (invMass != values[BODY_INV_MASS] || invMoment != values[BODY_INV_MOMENT])
+				fprintf(m_file, " inv_mass %.9g inv_moment %.9g", values[BODY_INV_MASS], values[BODY_INV_MOMENT]);
+			else if (density != 1)
+				fprintf(m_file, " density %.9g", density);
+		}
+
+		if (values[BODY_RESTITUTION] != DEFAULT_RESTITUTION)
+			fprintf(m_file, " restitution %.9g", values[BODY_RESTITUTION]);
+		if (record.flags & FIXED)
+			fprintf(m_file, " fixed");
+		if (record.flags & BULLET)
+			fprintf(m_file, " bullet");
+		if (record.flags & ASLEEP)
+			fprintf(m_file, " asleep");
+	}
+
+	if (record.color != DEFAULT_COLOR)
+	{
+		glm::vec4 color = UnpackColor(record.color);
+		fprintf(m_file, " color %.3g %.3g %.3g %.3g", color.r, color.g, color.b, color.a);
+	}
+	fprintf(m_file, "\n");
+}
+
+bool SceneFile::Fail(const char* format, ...)
+{
+	// only the first thing to go wrong is kept, as everything after tends to follow from it
+	if (m_failed)
+		return false;
+	m_failed = true;
+
+	int length = 0;
+	if (!m_writing && !m_binary && m_lineNumber > 0)
+		length = snprintf(m_error, sizeof(m_error), "line %d: ", m_lineNumber);
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(m_error + length, sizeof(m_error) - length, format, args);
+	va_end(args);
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+#include <stdio.h>
+
+#include "Broadphase.h"
+
+class PhysicsWorld;
+
+// scenes as data rather than code. There are two forms of the same thing: text to write by hand, and a compiled
+// binary form, a header and then fixed size records, for loading big scenes quickly. Both are read a batch of records
+// at a time and built straight into the world, so nothing is held in between, and the circles, boxes and springs
+// are built in the world's pools rather than allocated one by one.
+//
+// The text form is a line per setting or object, with # starting a comment:
+//
+//   gravity 0 -9
+//   dt 0.0166667
+//   substeps 1
+//   iterations 8 3                 velocity then position
+//   sleep 0.5                      seconds before bodies sleep, negative for never
+//   broadphase aabb_tree           brute_force, spatial_hash, sweep_and_prune or aabb_tree
+//
+//   plane ox oy nx ny [two_sided]
+//   circle x y radius [options]
+//   box x y width height [options]
+//   lander x y [options]
+//   spring body1 body2 restLength restoringForce [anchors x1 y1 x2 y2]
+//
+// Settings left out keep the world's defaults, and have to come before any objects. The options for bodies are
+// velocity vx vy, angle a, rotation r, density d, inv_mass m, inv_moment i, restitution e, fixed, bullet and asleep.
+// Anything can have a color r g b a. Springs join bodies by number, counting the circles, boxes and landers from 0
+// in the order they appear, and have to come after both of them.
+//
+// Every body goes into the broadphase as it's loaded, so for big scenes the broadphase makes a lot of difference:
+// the spatial hash takes each body in constant time, while the tree and sweep and prune slow down as they fill up.
+class SceneFile
+{
+public:
+	enum { MAGIC = 0x4e435350, VERSION = 1 };
+
+	enum Kind
+	{
+		PLANE,
+		CIRCLE,
+		BOX,
+		LANDER,
+		SPRING,
+		NUM_KINDS,
+	};
+
+	enum Flags
+	{
+		FIXED = 1,
+		BULLET = 2,
+		ASLEEP = 4,
+		TWO_SIDED = 8,
+	};
+
+	struct Settings
+	{
+		glm::vec2 gravity = glm::vec2(0, -1);
+		float dt = 1.0f / 60.0f;
+		int substeps = 1;
+		int velocityIterations = 8;
+		int positionIterations = 3;
+		float timeToSleep = 0.5f;
+		int broadphase = Broadphase::AABB_TREE;
+	};
+
+	struct Header
+	{
+		unsigned int magic, version;
+		Settings settings;
+		int numRecords, numBodies;
+	};
+
+	// one object. What the values are depends on the kind:
+	//   plane: origin x, y, normal x, y
+	//   circle, lander: x, y, vx, vy, angle, rotation, inverse mass, inverse moment, restitution, radius
+	//   box: the same as a circle up to the restitution, then width, height
+	//   spring: rest length, restoring force, anchor x1, y1, x2, y2
+	// Masses are kept inverted, as the world keeps them, so a scene saved from a world loads back exactly the same
+	struct Record
+	{
+		unsigned short kind, flags;
+		// 8 bits each of red, green, blue and alpha, starting from the bottom
+		unsigned int color;
+		// the bodies a spring joins
+		int body1, body2;
+		float values[11];
+	};
+
+	SceneFile() {}
+	SceneFile(const SceneFile&) = delete;
+	SceneFile& operator=(const SceneFile&) = delete;
+	~SceneFile();
+
+	// clears the world and builds the scene in it, returning false with Error() set if the file can't be read.
+	// A file that goes wrong part way through leaves what was read before that in the world
+	bool Load(PhysicsWorld& world, const char* path);
+	// writes the world's objects, so a scene built in code can be turned into a file. Particles aren't included
+	bool Save(PhysicsWorld& world, const char* path, bool binary);
+
+	// opens either form, telling them apart by the magic number, and reads the settings
+	bool Open(const char* path);
+	// reads up to max more records, returning how many were read. Fewer than max at the end or on an error
+	int Read(Record* records, int max);
+
+	bool Create(const char* path, bool binary, const Settings& fileSettings);
+	void Write(const Record& record);
+
+	// finishes reading or writing. False if anything went wrong along the way
+	bool Close();
+
+	bool IsBinary() { return m_binary; }
+	// what went wrong, with the line for text files
+	const char* Error() { return m_error; }
+
+	Settings settings;
+	// known up front for binary files. Text files count them as they're read
+	int numRecords = 0;
+	int numBodies = 0;
+
+private:
+	void Reset();
+	bool ReadText(Record& record);
+	bool ReadLine();
+	bool ParseSetting();
+	bool ParseRecord(Record& record);
+	bool ParseOptions(Record& record);
+	bool ParseNumbers(float* values, int count);
+	bool Check(const Settings& fileSettings);
+	bool Check(const Record& record);
+	void WriteText(const Record& record);
+	bool Fail(const char* format, ...);
+
+	FILE* m_file = nullptr;
+	bool m_binary = false;
+	bool m_writing = false;
+	bool m_failed = false;
+	char m_error[256] = "";
+
+	// records and bodies read or written so far
+	int m_records = 0;
+	int m_bodies = 0;
+
+	// the text line being parsed, split into words
+	enum { MAX_LINE = 512, MAX_WORDS = 32 };
+	char m_line[MAX_LINE];
+	char* m_words[MAX_WORDS];
+	int m_numWords = 0;
+	int m_word = 0;
+	int m_lineNumber = 0;
+	// Open() reads on past the settings to the first object, which is then waiting here to be parsed
+	bool m_pending = false;
+};
\ No newline at end of file
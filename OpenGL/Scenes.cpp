@@ -0,0 +1,196 @@
+#include <glm/glm/glm.hpp>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "Scenes.h"
+#include "PhysicsWorld.h"
+#include "Circle.h"
+#include "Plane.h"
+#include "Box.h"
+#include "Spring.h"
+#include "LunarLander.h"
+
+using namespace glm;
+
+void ResetPool(PhysicsWorld* world)
+{
+	world->gravity.y = 0;
+	world->AddObject(new Box(vec2(-10, 0), vec2(0, 0), 0, 1.0f, 10.0f, 10, true));
+	world->AddObject(new Box(vec2(10, 0), vec2(0, 0), 0, 1.0f, 10.0f, 10, true));
+	world->AddObject(new Box(vec2(-5, 7), vec2(0, 0), 0, 8.0f, 1.0f, 10, true));
+	world->AddObject(new Box(vec2(5, 7), vec2(0, 0), 0, 8.0f, 1.0f, 10, true));
+	world->AddObject(new Box(vec2(-5, -7), vec2(0, 0), 0, 8.0f, 1.0f, 10, true));
+	world->AddObject(new Box(vec2(5, -7), vec2(0, 0), 0, 8.0f, 1.0f, 10, true));
+
+	world->AddObject(new Circle(vec2(-5, 0), vec2(0, 0), 0.5f));
+
+	world->AddObject(new Circle(vec2(5, 0), vec2(0, 0), 0.5f));
+	world->AddObject(new Circle(vec2(6, 1), vec2(0, 0), 0.5f));
+	world->AddObject(new Circle(vec2(6, -1), vec2(0, 0), 0.5f));
+}
+
+void ResetLunarLander(PhysicsWorld* world)
+{
+	world->gravity.y = -9;
+	world->AddObject(new LunarLander(vec2(0, 0)));
+
+	world->AddObject(new Plane(vec2(0, -5), vec2(0, 1)));
+}
+
+void ResetSprings(PhysicsWorld* world)
+{
+	Circle* c[25];
+	for (int x = 0; x < 5; x++)
+	{
+		for (int y = 0; y < 5; y++)
+		{
+			Circle* c0 = new Circle(vec2(x * 2 - 5, y * 2), vec2(0, 0), 1.0f);
+			c[x + y * 5] = c0;
+			world->AddObject(c0);
+			if (x > 0)
+				world->AddObject(new Spring(c0, c[(x - 1) + y * 5], 2.0f, 150.0f, vec2(-0.5, 0), vec2(0.5, 0)));
+			if (y > 0)
+				world->AddObject(new Spring(c0, c[x + (y - 1) * 5], 2.0f, 150.0f, vec2(0, -0.5), vec2(0, 0.5)));
+		}
+	}
+
+	world->AddObject(new Plane(vec2(0, -5), vec2(0, 1)));
+	world->AddObject(new Plane(vec2(-7.1f, 0.0f), vec2(0.707f, 0.707f)));
+	world->AddObject(new Plane(vec2(7.1f, 0.0f), vec2(-1, 0)));
+}
+
+void ResetBasic(PhysicsWorld* world)
+{
+	Circle* c1 = new Circle(vec2(0, 5), vec2(-1, 0), 2.0f);
+	Circle* c2 = new Circle(vec2(2, 5), vec2(1, 0), 1.0f);
+	Circle* c3 = new Circle(vec2(-2, 5), vec2(2, 0), 0.5f, 100.0f);
+	world->AddObject(c1);
+	world->AddObject(c2);
+	world->AddObject(c3);
+	world->AddObject(new Spring(c1, c2, 6, 10));
+	world->AddObject(new Spring(c2, c3, 6, 10));
+	world->AddObject(new Spring(c1, c3, 6, 10));
+
+	world->AddObject(new Circle(vec2(0, 8), vec2(0.5f, 0), 0.5f));
+	world->AddObject(new Circle(vec2(0, 10), vec2(-0.5f, 0), 0.5f));
+	world->AddObject(new Circle(vec2(0, 12), vec2(0.5f, 0), 0.5f));
+
+	world->AddObject(new Box(vec2(-1, -4), vec2(0, 0), 0, 0.5f, 2.0f));
+	world->AddObject(new Box(vec2(1, -4), vec2(0, 0), 0, 0.5f, 2.0f));
+	world->AddObject(new Box(vec2(0, -2.75f), vec2(0, 0), 0.05f, 3.0f, 0.5f));
+
+	world->AddObject(new Box(vec2(0, 20), vec2(0, 0), 0, 1.0f, 3.0f));
+
+	world->AddObject(new Circle(vec2(0, 22), vec2(0.5f, 0), 2.0f));
+
+	world->AddObject(new Box(vec2(0, 4), vec2(0, 0), 0, 1.0f, 3.0f));
+
+	world->AddObject(new Plane(vec2(0, -5), vec2(0, 1)));
+	world->AddObject(new Plane(vec2(-7.1f, 0.0f), vec2(0.707f, 0.707f)));
+	world->AddObject(new Plane(vec2(7.1f, 0.0f), vec2(-1, 0)));
+}
+
+void ResetTwoBoxes(PhysicsWorld* world)
+{
+	static float angle1 = 0;
+	static float angle2 = 0;
+
+	world->gravity.y = -9;
+	//world->AddObject(new Box(vec2(0, 1.5f), vec2(0, 0), 0, 0.5f, 0.5f, 10));
+	//world->AddObject(new Box(vec2(0, -0.5), vec2(0, 0), 0, 0.5f, 0.5f, 10));
+	world->AddObject(new Box(vec2(1, 5), vec2(0, 0), angle1 * 3.1415f/180.0f, 3.0f, 1.0f));
+	world->AddObject(new Box(vec2(0, 9), vec2(0, 0), angle2 * 3.1415f/180.0f, 3.0f, 1.0f));
+	//world->AddObject(new Box(vec2(-4, 11), vec2(0, 0), -45, 3.0f, 1.0f));
+
+	//world->AddObject(new Circle(vec2(0, 22), vec2(0.5f, 0), 2.0f, 0.1f));
+
+	world->AddObject(new Plane(vec2(0, -5), vec2(0, 1)));
+	world->AddObject(new Plane(vec2(-7.1f, 0.0f), vec2(0.707f, 0.707f)));
+	world->AddObject(new Plane(vec2(7.1f, 0.0f), vec2(-1, 0)));
+}
+
+SceneFunction FindScene(const char* name)
+{
+	static const struct { const char* name; SceneFunction reset; } scenes[] =
+	{
+		{ "pool", ResetPool },
+		{ "lander", ResetLunarLander },
+		{ "springs", ResetSprings },
+		{ "basic", ResetBasic },
+		{ "twoboxes", ResetTwoBoxes },
+	};
+
+	for (auto& scene : scenes)
+	{
+		if (!strcmp(scene.name, name))
+			return scene.reset;
+	}
+	return nullptr;
+}
+
+void ResetRain(PhysicsWorld* world, int numCircles)
+{
+	world->gravity.y = -9;
+
+	// wide enough that the pile ends up roughly as deep as it is wide
+	float halfWidth = 0.5f * sqrtf((float)numCircles) + 2;
+	world->AddObject(new Plane(vec2(0, 0), vec2(0, 1)));
+	world->AddObject(new Plane(vec2(-halfWidth, 0), vec2(1, 0)));
+	world->AddObject(new Plane(vec2(halfWidth, 0), vec2(-1, 0)));
+
+	const float spacing = 1.1f;
+	int perRow = (int)(2 * halfWidth / spacing) - 1;
+	for (int i = 0; i < numCircles; i++)
+	{
+		int row = i / perRow, column = i % perRow;
+		// alternate rows are offset and the sizes cycle, so the circles don't just land in neat columns
+		vec2 position(-halfWidth + spacing * (column + 1) + (row % 2) * 0.25f, 2 + row * spacing);
+		vec2 velocity(0.5f * ((i % 3) - 1), 0);
+		float radius = 0.3f + 0.05f * (i % 5);
+		world->AddObject(new Circle(position, velocity, radius));
+	}
+}
+
+void ResetPyramid(PhysicsWorld* world, int base)
+{
+	world->gravity.y = -9;
+	world->AddObject(new Plane(vec2(0, 0), vec2(0, 1)));
+
+	for (int row = 0; row < base; row++)
+	{
+		int count = base - row;
+		for (int i = 0; i < count; i++)
+		{
+			vec2 position((i - (count - 1) * 0.5f) * 1.05f, 0.5f + row);
+			world->AddObject(new Box(position, vec2(0, 0), 0, 1.0f, 1.0f));
+		}
+	}
+}
+
+void ResetCloth(PhysicsWorld* world, int width, int height)
+{
+	world->gravity.y = -9;
+	world->AddObject(new Plane(vec2(0, 0), vec2(0, 1)));
+
+	const float spacing = 0.5f;
+	const float stiffness = 40.0f;
+	// every few nodes along the top are pinned, like a curtain on hooks. The springs stretch further the more
+	// hangs off them, and stretched far enough they go unstable, so sheets much over 50 high blow up
+	const int pinSpacing = 8;
+	std::vector<Circle*> nodes(width * height);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			Circle* node = new Circle(vec2((x - (width - 1) * 0.5f) * spacing, 2 + (height - y) * spacing), vec2(0, 0), 0.2f);
+			node->def.fixed = y == 0 && (x % pinSpacing == 0 || x == width - 1);
+			nodes[x + y * width] = node;
+			world->AddObject(node);
+			if (x > 0)
+				world->AddObject(new Spring(node, nodes[(x - 1) + y * width], spacing, stiffness));
+			if (y > 0)
+				world->AddObject(new Spring(node, nodes[x + (y - 1) * width], spacing, stiffness));
+		}
+	}
+}
\ No newline at end of file
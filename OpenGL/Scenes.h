@@ -0,0 +1,23 @@
+#pragma once
+
+class PhysicsWorld;
+
+typedef void(*SceneFunction)(PhysicsWorld* world);
+
+// the built in test scenes. Each one adds its objects to an already cleared world.
+void ResetPool(PhysicsWorld* world);
+void ResetLunarLander(PhysicsWorld* world);
+void ResetSprings(PhysicsWorld* world);
+void ResetBasic(PhysicsWorld* world);
+void ResetTwoBoxes(PhysicsWorld* world);
+
+// the built in scenes by name: pool, lander, springs, basic or twoboxes. Null for anything else
+SceneFunction FindScene(const char* name);
+
+// scaled up scenes for benchmarking, sized by their arguments
+// circles of mixed sizes falling in rows into a walled tray
+void ResetRain(PhysicsWorld* world, int numCircles);
+// a pyramid of boxes, base boxes wide at the bottom
+void ResetPyramid(PhysicsWorld* world, int base);
+// a sheet of small circles joined to their neighbours by springs, hanging from points along its top edge
+void ResetCloth(PhysicsWorld* world, int width, int height);
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+// switches for the hand vectorised loops. SIMD_X86 is defined where SSE2 and AVX2 intrinsics can be used, picked
+// between at run time by Integrator::InstructionSet, and TARGET_SSE2 and TARGET_AVX2 mark the functions using them
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC lets any function use any intrinsic
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+// gcc and clang need to be told which functions may use which instructions
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
\ No newline at end of file
@@ -0,0 +1,571 @@
+#include <glm/glm/glm.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "Snapshot.h"
+#include "PhysicsWorld.h"
+#include "Plane.h"
+#include "Circle.h"
+#include "Box.h"
+#include "Spring.h"
+#include "LunarLander.h"
+
+// size of each section's elements, checked before a block is trusted
+static const unsigned int s_strides[Snapshot::NUM_SECTIONS] =
+{
+	sizeof(glm::vec2),
+	sizeof(glm::vec2),
+	sizeof(float),
+	sizeof(float),
+	sizeof(float),
+	sizeof(float),
+	sizeof(float),
+	sizeof(unsigned char),
+	sizeof(float),
+	sizeof(glm::vec2),
+	sizeof(float),
+	sizeof(glm::vec2),
+	sizeof(glm::vec2),
+	sizeof(int),
+	sizeof(int),
+	sizeof(int),
+	sizeof(Snapshot::Object),
+	sizeof(Snapshot::Expiry),
+	sizeof(Snapshot::Contact),
+	sizeof(Snapshot::Island),
+	sizeof(int),
+	sizeof(Snapshot::Contact),
+	sizeof(int),
+	sizeof(int),
+	sizeof(float),
+	sizeof(float),
+	sizeof(float),
+	sizeof(float),
+	sizeof(float),
+};
+
+template<class T>
+static const T* Get(const void* data, const Snapshot::Range& range)
+{
+	return (const T*)((const char*)data + range.offset);
+}
+
+template<class T>
+static void Read(const void* data, const Snapshot::Range& range, std::vector<T>& items)
+{
+	const T* first = Get<T>(data, range);
+	items.assign(first, first + range.count);
+}
+
+static int Kind(PhysicsObject* obj)
+{
+	switch (obj->oType)
+	{
+	case PhysicsObject::PLANE:
+		return Snapshot::PLANE;
+	case PhysicsObject::CIRCLE:
+		return dynamic_cast<LunarLander*>(obj) ? Snapshot::LANDER : Snapshot::CIRCLE;
+	case PhysicsObject::BOX:
+		return Snapshot::BOX;
+	default:
+		return Snapshot::SPRING;
+	}
+}
+
+static void WriteObject(PhysicsObject* obj, Snapshot::Object& record)
+{
+	record.kind = Kind(obj);
+	record.lifeSpan = obj->lifeSpan;
+	record.handle = -1;
+	record.handle2 = -1;
+	record.color = obj->color;
+
+	switch (record.kind)
+	{
+	case Snapshot::PLANE:
+	{
+		Plane* plane = (Plane*)obj;
+		record.params[0] = plane->origin.x;
+		record.params[1] = plane->origin.y;
+		record.params[2] = plane->normal.x;
+		record.params[3] = plane->normal.y;
+		record.params[4] = plane->oneSided ? 1.0f : 0.0f;
+		break;
+	}
+	case Snapshot::CIRCLE:
+	case Snapshot::LANDER:
+		record.handle = ((Circle*)obj)->handle;
+		record.params[0] = ((Circle*)obj)->radius;
+		break;
+	case Snapshot::BOX:
+		record.handle = ((Box*)obj)->handle;
+		record.params[0] = ((Box*)obj)->width;
+		record.params[1] = ((Box*)obj)->height;
+		break;
+	case Snapshot::SPRING:
+	{
+		Spring* spring = (Spring*)obj;
+		record.handle = spring->body1->handle;
+		record.handle2 = spring->body2->handle;
+		record.params[0] = spring->contact1.x;
+		record.params[1] = spring->contact1.y;
+		record.params[2] = spring->contact2.x;
+		record.params[3] = spring->contact2.y;
+		record.params[4] = spring->restLength;
+		record.params[5] = spring->restoringForce;
+		break;
+	}
+	}
+}
+
+static RigidBody* FindBody(PhysicsWorld& world, int handle)
+{
+	return world.bodies.body[world.bodies.Index(handle)];
+}
+
+// everything but the life span, which is left to the caller so AddObject() doesn't give the object a new expiry
+static void ReadObject(PhysicsWorld& world, const Snapshot::Object& record, PhysicsObject* obj)
+{
+	obj->color = record.color;
+
+	switch (record.kind)
+	{
+	case Snapshot::PLANE:
+		((Plane*)obj)->origin = glm::vec2(record.params[0], record.params[1]);
+		((Plane*)obj)->normal = glm::vec2(record.params[2], record.params[3]);
+		((Plane*)obj)->oneSided = record.params[4] != 0;
+		break;
+	case Snapshot::CIRCLE:
+	case Snapshot::LANDER:
+		((Circle*)obj)->radius = record.params[0];
+		break;
+	case Snapshot::BOX:
+		((Box*)obj)->width = record.params[0];
+		((Box*)obj)->height = record.params[1];
+		break;
+	case Snapshot::SPRING:
+		// the bodies at the ends have to have been bound to their slots already
+		((Spring*)obj)->body1 = FindBody(world, record.handle);
+		((Spring*)obj)->body2 = FindBody(world, record.handle2);
+		((Spring*)obj)->contact1 = glm::vec2(record.params[0], record.params[1]);
+		((Spring*)obj)->contact2 = glm::vec2(record.params[2], record.params[3]);
+		((Spring*)obj)->restLength = record.params[4];
+		((Spring*)obj)->restoringForce = record.params[5];
+		break;
+	}
+}
+
+static PhysicsObject* CreateObject(const Snapshot::Object& record)
+{
+	switch (record.kind)
+	{
+	case Snapshot::PLANE:
+		return new Plane();
+	case Snapshot::CIRCLE:
+		return new Circle();
+	case Snapshot::LANDER:
+		return new LunarLander();
+	case Snapshot::BOX:
+		return new Box();
+	default:
+		return new Spring();
+	}
+}
+
+// points the body at its slot and the slot back at the body. Its state is already in the store
+static void BindBody(PhysicsWorld& world, RigidBody* body, int handle)
+{
+	body->world = &world;
+	body->store = &world.bodies;
+	body->handle = handle;
+	world.bodies.body[world.bodies.Index(handle)] = body;
+}
+
+static bool IsBodyKind(int kind)
+{
+	return kind == Snapshot::CIRCLE || kind == Snapshot::LANDER || kind == Snapshot::BOX;
+}
+
+// whether the world still holds the objects the snapshot was taken of, so they can be kept rather than made again
+static bool CanReuse(PhysicsWorld& world, const Snapshot::Object* objects, int count)
+{
+	if ((int)world.m_physicsObjects.size() != count)
+		return false;
+
+	const Snapshot::Object* record = objects;
+	for (auto obj : world.m_physicsObjects)
+	{
+		if (Kind(obj) != record->kind)
+			return false;
+		if (IsBodyKind(record->kind) && ((RigidBody*)obj)->handle != record->handle)
+			return false;
+		if (record->kind == Snapshot::SPRING &&
+			(((Spring*)obj)->body1->handle != record->handle || ((Spring*)obj)->body2->handle != record->handle2))
+			return false;
+		record++;
+	}
+	return true;
+}
+
+static void WriteContact(PhysicsWorld& world, const ContactManifold& contact, Snapshot::Contact& record)
+{
+	record.manifold = contact;
+	record.manifold.a = nullptr;
+	record.manifold.b = nullptr;
+	record.manifold.plane = nullptr;
+	record.a = contact.a ? contact.a->handle : -1;
+	record.b = contact.b ? contact.b->handle : -1;
+	record.plane = contact.plane ? (int)(std::find(world.m_planes.begin(), world.m_planes.end(), contact.plane) - world.m_planes.begin()) : -1;
+}
+
+static void ReadContacts(PhysicsWorld& world, const Snapshot::Contact* records, int count, std::vector<ContactManifold>& contacts)
+{
+	contacts.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		const Snapshot::Contact& record = records[i];
+		ContactManifold& contact = contacts[i];
+		contact = record.manifold;
+		contact.a = record.a >= 0 ? FindBody(world, record.a) : nullptr;
+		contact.b = record.b >= 0 ? FindBody(world, record.b) : nullptr;
+		contact.plane = record.plane >= 0 ? world.m_planes[record.plane] : nullptr;
+	}
+}
+
+void* Snapshot::Reserve(int section, size_t count, size_t stride)
+{
+	size_t offset = m_size;
+	m_size += (count * stride + 7) & ~(size_t)7;
+	m_blob.resize(m_size / 8);
+
+	Range& range = GetHeader().sections[section];
+	range.offset = (unsigned int)offset;
+	range.count = (unsigned int)count;
+	range.stride = (unsigned int)stride;
+	return (char*)m_blob.data() + offset;
+}
+
+void Snapshot::Capture(PhysicsWorld& world)
+{
+	// the block is zeroed as it grows, so padding and unused parameters always come out the same
+	m_size = (sizeof(Header) + 7) & ~(size_t)7;
+	m_blob.assign(m_size / 8, 0);
+
+	Header& header = GetHeader();
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.gravity = world.gravity;
+	header.dt = world.dt;
+	header.substeps = world.substeps;
+	header.maxSteps = world.maxSteps;
+	header.interpolation = world.interpolation;
+	header.velocityIterations = world.velocityIterations;
+	header.positionIterations = world.positionIterations;
+	header.timeToSleep = world.timeToSleep;
+	header.input = world.input;
+	header.broadphase = world.m_broadphase->GetType();
+	header.numAwake = world.bodies.m_numAwake;
+	header.stepCount = world.m_stepCount;
+	header.accumulator = world.m_accumulator;
+	header.particlesCollide = world.particleSystem.collide ? 1 : 0;
+	header.particleRestitution = world.particleSystem.restitution;
+
+	BodyStore& bodies = world.bodies;
+	Write(BODY_POSITION, bodies.position);
+	Write(BODY_VELOCITY, bodies.velocity);
+	Write(BODY_ANGLE, bodies.angle);
+	Write(BODY_ROTATION, bodies.rotation);
+	Write(BODY_INV_MASS, bodies.invMass);
+	Write(BODY_INV_MOMENT, bodies.invMoment);
+	Write(BODY_RESTITUTION, bodies.restitution);
+	Write(BODY_FLAGS, bodies.flags);
+	Write(BODY_SLEEP_TIME, bodies.sleepTime);
+	Write(BODY_PREVIOUS_POSITION, bodies.previousPosition);
+	Write(BODY_PREVIOUS_ANGLE, bodies.previousAngle);
+	Write(BODY_LOCAL_X, bodies.localX);
+	Write(BODY_LOCAL_Y, bodies.localY);
+	Write(BODY_HANDLE, bodies.handle);
+	Write(HANDLE_INDEX, bodies.m_indices);
+	Write(FREE_HANDLES, bodies.m_freeHandles);
+
+	m_objectIndices.clear();
+	Object* objects = Reserve<Object>(OBJECTS, world.m_physicsObjects.size());
+	int count = 0;
+	for (auto obj : world.m_physicsObjects)
+	{
+		if (obj->lifeSpan > 0)
+			m_objectIndices[obj] = count;
+		WriteObject(obj, objects[count++]);
+	}
+
+	int numExpiries = 0;
+	for (auto& bucket : world.m_expiryWheel)
+		numExpiries += (int)bucket.size();
+
+	Expiry* expiries = Reserve<Expiry>(EXPIRIES, numExpiries);
+	for (auto& bucket : world.m_expiryWheel)
+	{
+		for (auto& expiry : bucket)
+		{
+			expiries->step = expiry.step;
+			expiries->object = m_objectIndices[expiry.obj];
+			expiries++;
+		}
+	}
+
+	Contact* contacts = Reserve<Contact>(CONTACTS, world.m_previousContacts.size());
+	for (auto& contact : world.m_previousContacts)
+		WriteContact(world, contact, *contacts++);
+
+	Island* islands = Reserve<Island>(SLEEPING_ISLANDS, world.m_sleepingIslands.size());
+	int numHandles = 0;
+	int numContacts = 0;
+	for (auto& island : world.m_sleepingIslands)
+	{
+		islands->firstHandle = numHandles;
+		islands->numHandles = (int)island.handles.size();
+		islands->firstContact = numContacts;
+		islands->numContacts = (int)island.contacts.size();
+		numHandles += islands->numHandles;
+		numContacts += islands->numContacts;
+		islands++;
+	}
+
+	int* handles = Reserve<int>(SLEEPING_HANDLES, numHandles);
+	for (auto& island : world.m_sleepingIslands)
+		handles = std::copy(island.handles.begin(), island.handles.end(), handles);
+
+	contacts = Reserve<Contact>(SLEEPING_CONTACTS, numContacts);
+	for (auto& island : world.m_sleepingIslands)
+	{
+		for (auto& contact : island.contacts)
+			WriteContact(world, contact, *contacts++);
+	}
+
+	Write(FREE_SLEEPING_ISLANDS, world.m_freeSleepingIslands);
+	Write(HANDLE_ISLAND, world.m_handleIsland);
+
+	Write(PARTICLE_X, world.particleSystem.x);
+	Write(PARTICLE_Y, world.particleSystem.y);
+	Write(PARTICLE_VX, world.particleSystem.vx);
+	Write(PARTICLE_VY, world.particleSystem.vy);
+	Write(PARTICLE_LIFE, world.particleSystem.life);
+
+	GetHeader().size = (unsigned int)m_size;
+}
+
+bool Snapshot::Restore(PhysicsWorld& world) const
+{
+	return m_size > 0 && Restore(world, m_blob.data(), m_size);
+}
+
+bool Snapshot::Restore(PhysicsWorld& world, const void* data, size_t size)
+{
+	if (!IsValid(data, size))
+		return false;
+
+	const Header& header = *(const Header*)data;
+	const Range* sections = header.sections;
+	const Object* objects = Get<Object>(data, sections[OBJECTS]);
+	int numObjects = sections[OBJECTS].count;
+	Broadphase::BroadphaseType broadphase = (Broadphase::BroadphaseType)header.broadphase;
+
+	// restoring isn't something a recording can play back
+	Replay* recording = world.recording;
+	world.recording = nullptr;
+
+	bool reuse = CanReuse(world, objects, numObjects);
+	if (!reuse)
+	{
+		world.Clear();
+		world.SetBroadphase(broadphase);
+	}
+
+	world.gravity = header.gravity;
+	world.dt = header.dt;
+	world.substeps = header.substeps;
+	world.maxSteps = header.maxSteps;
+	world.interpolation = header.interpolation;
+	world.velocityIterations = header.velocityIterations;
+	world.positionIterations = header.positionIterations;
+	world.timeToSleep = header.timeToSleep;
+	world.input = header.input;
+	world.m_stepCount = header.stepCount;
+	world.m_accumulator = header.accumulator;
+	world.particleSystem.collide = header.particlesCollide != 0;
+	world.particleSystem.restitution = header.particleRestitution;
+
+	BodyStore& bodies = world.bodies;
+	Read(data, sections[BODY_POSITION], bodies.position);
+	Read(data, sections[BODY_VELOCITY], bodies.velocity);
+	Read(data, sections[BODY_ANGLE], bodies.angle);
+	Read(data, sections[BODY_ROTATION], bodies.rotation);
+	Read(data, sections[BODY_INV_MASS], bodies.invMass);
+	Read(data, sections[BODY_INV_MOMENT], bodies.invMoment);
+	Read(data, sections[BODY_RESTITUTION], bodies.restitution);
+	Read(data, sections[BODY_FLAGS], bodies.flags);
+	Read(data, sections[BODY_SLEEP_TIME], bodies.sleepTime);
+	Read(data, sections[BODY_PREVIOUS_POSITION], bodies.previousPosition);
+	Read(data, sections[BODY_PREVIOUS_ANGLE], bodies.previousAngle);
+	Read(data, sections[BODY_LOCAL_X], bodies.localX);
+	Read(data, sections[BODY_LOCAL_Y], bodies.localY);
+	Read(data, sections[BODY_HANDLE], bodies.handle);
+	Read(data, sections[HANDLE_INDEX], bodies.m_indices);
+	Read(data, sections[FREE_HANDLES], bodies.m_freeHandles);
+	bodies.m_numAwake = header.numAwake;
+	bodies.body.assign(bodies.position.size(), nullptr);
+
+	// what each record in OBJECTS became, for the expiries
+	std::vector<PhysicsObject*> created;
+	if (reuse)
+	{
+		created.assign(world.m_physicsObjects.begin(), world.m_physicsObjects.end());
+		for (int i = 0; i < numObjects; i++)
+		{
+			if (IsBodyKind(objects[i].kind))
+				BindBody(world, (RigidBody*)created[i], objects[i].handle);
+		}
+		for (int i = 0; i < numObjects; i++)
+		{
+			ReadObject(world, objects[i], created[i]);
+			created[i]->lifeSpan = objects[i].lifeSpan;
+		}
+
+		// the bodies have all moved, so the broadphase is built again from scratch, just as it is for new objects
+		world.SetBroadphase(broadphase);
+	}
+	else
+	{
+		created.resize(numObjects);
+		for (int i = 0; i < numObjects; i++)
+		{
+			created[i] = CreateObject(objects[i]);
+			if (IsBodyKind(objects[i].kind))
+				BindBody(world, (RigidBody*)created[i], objects[i].handle);
+		}
+		for (int i = 0; i < numObjects; i++)
+		{
+			ReadObject(world, objects[i], created[i]);
+			world.AddObject(created[i]);
+			created[i]->lifeSpan = objects[i].lifeSpan;
+		}
+	}
+
+	for (auto& bucket : world.m_expiryWheel)
+		bucket.clear();
+	world.m_numTransient = 0;
+	const Expiry* expiries = Get<Expiry>(data, sections[EXPIRIES]);
+	for (int i = 0; i < (int)sections[EXPIRIES].count; i++)
+	{
+		world.AddExpiry(created[expiries[i].object], expiries[i].step - world.m_stepCount);
+	}
+
+	// this step's pairs and contacts are worked out afresh, but last step's are needed to warm start from
+	world.m_pairs.clear();
+	world.m_contacts.clear();
+	ReadContacts(world, Get<Contact>(data, sections[CONTACTS]), sections[CONTACTS].count, world.m_previousContacts);
+	world.m_previousKeys.resize(world.m_previousContacts.size());
+	for (int i = 0; i < (int)world.m_previousContacts.size(); i++)
+		world.m_previousKeys[i] = PhysicsWorld::MakeKey(world.m_previousContacts[i], i);
+	std::sort(world.m_previousKeys.begin(), world.m_previousKeys.end());
+	world.m_previousKeysSorted = true;
+
+	const Island* islands = Get<Island>(data, sections[SLEEPING_ISLANDS]);
+	const int* handles = Get<int>(data, sections[SLEEPING_HANDLES]);
+	const Contact* contacts = Get<Contact>(data, sections[SLEEPING_CONTACTS]);
+	world.m_sleepingIslands.resize(sections[SLEEPING_ISLANDS].count);
+	for (int i = 0; i < (int)world.m_sleepingIslands.size(); i++)
+	{
+		const Island& island = islands[i];
+		world.m_sleepingIslands[i].handles.assign(handles + island.firstHandle, handles + island.firstHandle + island.numHandles);
+		ReadContacts(world, contacts + island.firstContact, island.numContacts, world.m_sleepingIslands[i].contacts);
+	}
+	Read(data, sections[FREE_SLEEPING_ISLANDS], world.m_freeSleepingIslands);
+	Read(data, sections[HANDLE_ISLAND], world.m_handleIsland);
+
+	Read(data, sections[PARTICLE_X], world.particleSystem.x);
+	Read(data, sections[PARTICLE_Y], world.particleSystem.y);
+	Read(data, sections[PARTICLE_VX], world.particleSystem.vx);
+	Read(data, sections[PARTICLE_VY], world.particleSystem.vy);
+	Read(data, sections[PARTICLE_LIFE], world.particleSystem.life);
+
+	world.recording = recording;
+	return true;
+}
+
+// checks the layout, so nothing's read from outside the block. What's in it is trusted to have come from Capture()
+bool Snapshot::IsValid(const void* data, size_t size)
+{
+	// everything's read in place, so the block has to be aligned as it was when it was written
+	if (!data || ((size_t)data & 7) != 0 || size < sizeof(Header))
+		return false;
+
+	const Header& header = *(const Header*)data;
+	if (header.magic != MAGIC || header.version != VERSION || header.size > size)
+		return false;
+	if (header.broadphase < Broadphase::BRUTE_FORCE || header.broadphase > Broadphase::AABB_TREE)
+		return false;
+
+	for (int i = 0; i < NUM_SECTIONS; i++)
+	{
+		const Range& range = header.sections[i];
+		if (range.stride != s_strides[i] || range.offset % 8 != 0 || range.offset < sizeof(Header) ||
+			range.offset + (unsigned long long)range.count * range.stride > header.size)
+			return false;
+	}
+
+	// every body has an entry in each of the body arrays, and every particle in each particle array
+	unsigned int numBodies = header.sections[BODY_POSITION].count;
+	for (int i = BODY_POSITION; i <= BODY_HANDLE; i++)
+	{
+		if (header.sections[i].count != numBodies)
+			return false;
+	}
+	for (int i = PARTICLE_X; i <= PARTICLE_LIFE; i++)
+	{
+		if (header.sections[i].count != header.sections[PARTICLE_X].count)
+			return false;
+	}
+	return header.numAwake >= 0 && header.numAwake <= (int)numBodies;
+}
+
+bool Snapshot::Save(const char* path) const
+{
+	FILE* file = fopen(path, "wb");
+	if (!file)
+		return false;
+
+	fwrite(m_blob.data(), 1, m_size, file);
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+	return ok;
+}
+
+bool Snapshot::Load(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	bool ok = size >= (long)sizeof(Header);
+	if (ok)
+	{
+		m_blob.assign((size + 7) / 8, 0);
+		m_size = (size_t)size;
+		ok = fread(m_blob.data(), 1, m_size, file) == m_size && IsValid(m_blob.data(), m_size);
+	}
+	fclose(file);
+
+	if (!ok)
+	{
+		m_blob.clear();
+		m_size = 0;
+	}
+	return ok;
+}
\ No newline at end of file
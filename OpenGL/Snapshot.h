@@ -0,0 +1,170 @@
+#pragma once
+#include <glm/glm/glm.hpp>
+#include <stddef.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+#include "Contact.h"
+
+class PhysicsObject;
+class PhysicsWorld;
+
+// the complete state of a world in one block of memory: every body, object, particle, expiry, sleeping island
+// and the contacts kept for warm starting, plus the world's settings. The block is a header followed by flat
+// arrays at 8 byte aligned offsets, with nothing in it that depends on where it's loaded, so it can be saved to a
+// file and mapped straight back in. Restoring copies the arrays across; only the objects themselves are rebuilt,
+// and not even those when the world being restored into already holds the same objects (as when rolling back).
+//
+// The broadphase is rebuilt rather than saved, so a restored world can find its pairs in a different order to the
+// world the snapshot was taken from, and drift from it over time. Any two worlds restored from the same snapshot
+// step exactly the same, though.
+class Snapshot
+{
+public:
+	enum { MAGIC = 0x504e5350, VERSION = 2 };
+
+	enum Section
+	{
+		BODY_POSITION,
+		BODY_VELOCITY,
+		BODY_ANGLE,
+		BODY_ROTATION,
+		BODY_INV_MASS,
+		BODY_INV_MOMENT,
+		BODY_RESTITUTION,
+		BODY_FLAGS,
+		BODY_SLEEP_TIME,
+		BODY_PREVIOUS_POSITION,
+		BODY_PREVIOUS_ANGLE,
+		BODY_LOCAL_X,
+		BODY_LOCAL_Y,
+		BODY_HANDLE,
+		HANDLE_INDEX,
+		FREE_HANDLES,
+		OBJECTS,
+		EXPIRIES,
+		CONTACTS,
+		SLEEPING_ISLANDS,
+		SLEEPING_HANDLES,
+		SLEEPING_CONTACTS,
+		FREE_SLEEPING_ISLANDS,
+		HANDLE_ISLAND,
+		PARTICLE_X,
+		PARTICLE_Y,
+		PARTICLE_VX,
+		PARTICLE_VY,
+		PARTICLE_LIFE,
+		NUM_SECTIONS,
+	};
+
+	// where an array is, in bytes from the start of the block, and the size of its elements for checking against
+	struct Range
+	{
+		unsigned int offset, count, stride;
+	};
+
+	struct Header
+	{
+		unsigned int magic, version;
+		// of the whole block
+		unsigned int size;
+
+		glm::vec2 gravity;
+		float dt;
+		int substeps, maxSteps;
+		float interpolation;
+		int velocityIterations, positionIterations;
+		float timeToSleep;
+		unsigned int input;
+		int broadphase;
+		int numAwake;
+		int stepCount;
+		float accumulator;
+		int particlesCollide;
+		float particleRestitution;
+
+		Range sections[NUM_SECTIONS];
+	};
+
+	enum ObjectKind
+	{
+		PLANE,
+		CIRCLE,
+		BOX,
+		SPRING,
+		LANDER,
+	};
+
+	// one of the world's objects
+	struct Object
+	{
+		int kind;
+		int lifeSpan;
+		// the body's handle. Springs have the handles of the bodies at either end
+		int handle, handle2;
+		glm::vec4 color;
+		// circle and lander: radius. box: width, height. plane: origin, normal, one sided.
+		// spring: the two contact points, rest length, restoring force
+		float params[7];
+	};
+
+	struct Expiry
+	{
+		int step;
+		// index into OBJECTS
+		int object;
+	};
+
+	// a contact with its pointers swapped for handles, and an index into the world's planes
+	struct Contact
+	{
+		ContactManifold manifold;
+		int a, b, plane;
+	};
+
+	// ranges of SLEEPING_HANDLES and SLEEPING_CONTACTS
+	struct Island
+	{
+		int firstHandle, numHandles;
+		int firstContact, numContacts;
+	};
+
+	// replaces what's held with the world's state. The memory is kept between captures, so capturing every
+	// step to roll back to doesn't allocate once it's grown
+	void Capture(PhysicsWorld& world);
+	// returns false, leaving the world alone, if nothing's been captured or loaded
+	bool Restore(PhysicsWorld& world) const;
+	// restores from a block laid out as Data() is, such as a file mapped into memory. Returns false, leaving the
+	// world alone, if it isn't a snapshot this version can read
+	static bool Restore(PhysicsWorld& world, const void* data, size_t size);
+
+	bool Save(const char* path) const;
+	bool Load(const char* path);
+
+	const void* Data() const { return m_blob.data(); }
+	size_t Size() const { return m_size; }
+
+private:
+	Header& GetHeader() { return *(Header*)m_blob.data(); }
+	// adds a section of count elements to the end of the block, returning where to write them. Anything already
+	// returned is moved when the block grows, so each section has to be filled in before the next is reserved
+	void* Reserve(int section, size_t count, size_t stride);
+	template<class T>
+	T* Reserve(int section, size_t count) { return (T*)Reserve(section, count, sizeof(T)); }
+	template<class T>
+	void Write(int section, const std::vector<T>& items)
+	{
+		T* data = Reserve<T>(section, items.size());
+		if (!items.empty())
+			memcpy(data, items.data(), items.size() * sizeof(T));
+	}
+
+	static bool IsValid(const void* data, size_t size);
+
+	// in 8 byte words so the sections can all be aligned
+	std::vector<unsigned long long> m_blob;
+	size_t m_size = 0;
+	// where each object with a limited life span went in OBJECTS, so its expiry can refer to it
+	std::unordered_map<PhysicsObject*, int> m_objectIndices;
+};
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include <glm/glm/glm.hpp>
+#include <math.h>
+
+#include "SpatialHash.h"
+#include "RigidBody.h"
+
+void SpatialHash::AddBody(RigidBody* body)
+{
+	body->proxy = (int)m_bodies.size();
+	m_bodies.push_back(body);
+	m_aabbs.push_back(body->GetAABB());
+	// counted as awake until the next step has had a look at it, so it's binned from wherever it is by then
+	m_awake.push_back(true);
+	m_isLarge.push_back(false);
+	m_restingChanged = true;
+}
+
+void SpatialHash::RemoveBody(RigidBody* body)
+{
+	int index = body->proxy;
+	m_bodies[index] = m_bodies.back();
+	m_bodies[index]->proxy = index;
+	m_bodies.pop_back();
+	m_aabbs[index] = m_aabbs.back();
+	m_aabbs.pop_back();
+	m_awake[index] = m_awake.back();
+	m_awake.pop_back();
+	m_isLarge[index] = m_isLarge.back();
+	m_isLarge.pop_back();
+	body->proxy = -1;
+	m_restingChanged = true;
+}
+
+// bins the bodies into the cells they cover and sorts the cells into hash buckets
+void SpatialHash::Build(Grid& grid, const std::vector<int>& bodies)
+{
+	grid.entries.clear();
+	grid.large.clear();
+	for (int i : bodies)
+	{
+		int x0 = CellCoord(m_aabbs[i].min.x), x1 = CellCoord(m_aabbs[i].max.x);
+		int y0 = CellCoord(m_aabbs[i].min.y), y1 = CellCoord(m_aabbs[i].max.y);
+		m_isLarge[i] = (x1 - x0 + 1) * (y1 - y0 + 1) > maxCellsPerBody;
+		if (m_isLarge[i])
+		{
+			grid.large.push_back(i);
+			continue;
+		}
+		for (int x = x0; x <= x1; x++)
+			for (int y = y0; y <= y1; y++)
+				grid.entries.push_back({ x, y, i });
+	}
+
+	// counting sort the entries into hash buckets
+	grid.tableSize = 16;
+	while (grid.tableSize < grid.entries.size() * 2)
+		grid.tableSize *= 2;
+	grid.bucketStart.assign(grid.tableSize + 1, 0);
+	for (auto& e : grid.entries)
+		grid.bucketStart[Hash(e.x, e.y, grid.tableSize) + 1]++;
+	for (unsigned int b = 0; b < grid.tableSize; b++)
+		grid.bucketStart[b + 1] += grid.bucketStart[b];
+	grid.sorted.resize(grid.entries.size());
+	for (auto& e : grid.entries)
+		grid.sorted[grid.bucketStart[Hash(e.x, e.y, grid.tableSize)]++] = e;
+	// the scatter moved every start along to the next bucket, so shift them back
+	for (unsigned int b = grid.tableSize; b > 0; b--)
+		grid.bucketStart[b] = grid.bucketStart[b - 1];
+	grid.bucketStart[0] = 0;
+}
+
+void SpatialHash::TestInCell(const Entry& e1, const Entry& e2, std::vector<BroadphasePair>& pairs)
+{
+	const AABB& a = m_aabbs[e1.body];
+	const AABB& b = m_aabbs[e2.body];
+	if (!a.Overlaps(b))
+		return;
+	if (CellCoord(fmaxf(a.min.x, b.min.x)) != e1.x || CellCoord(fmaxf(a.min.y, b.min.y)) != e1.y)
+		return;
+	if (CanCollide(m_bodies[e1.body], m_bodies[e2.body]))
+		pairs.push_back(MakePair(m_bodies[e1.body], m_bodies[e2.body]));
+}
+
+void SpatialHash::FindPairs(std::vector<BroadphasePair>& pairs)
+{
+	int count = (int)m_bodies.size();
+	if (count < 2)
+		return;
+
+	// only awake bodies have moved. One that's just stopped is looked at once more, to get where it came to rest
+	m_awakeBodies.clear();
+	for (int i = 0; i < count; i++)
+	{
+		bool awake = m_bodies[i]->IsAwake();
+		if (awake || m_awake[i])
+			m_aabbs[i] = m_bodies[i]->GetAABB();
+		if (awake != m_awake[i])
+		{
+			m_awake[i] = awake;
+			m_restingChanged = true;
+		}
+		if (awake)
+			m_awakeBodies.push_back(i);
+	}
+
+	if (m_restingChanged)
+	{
+		// twice the average body size means most bodies only touch one to four cells. The resting grid is
+		// binned with it, so it stays the same until that grid is built again
+		float totalSize = 0;
+		for (int i = 0; i < count; i++)
+		{
+			glm::vec2 size = m_aabbs[i].max - m_aabbs[i].min;
+			totalSize += fmaxf(size.x, size.y);
+		}
+		float size = cellSize > 0 ? cellSize : 2.0f * totalSize / count;
+		if (size <= 0)
+			size = 1;
+		m_invCellSize = 1.0f / size;
+
+		m_restingBodies.clear();
+		for (int i = 0; i < count; i++)
+		{
+			if (!m_awake[i])
+				m_restingBodies.push_back(i);
+		}
+		Build(m_restingGrid, m_restingBodies);
+		m_restingChanged = false;
+	}
+	Build(m_awakeGrid, m_awakeBodies);
+
+	// test the awake bodies within each bucket against each other
+	const Grid& awake = m_awakeGrid;
+	for (unsigned int b = 0; b < awake.tableSize; b++)
+	{
+		unsigned int end = awake.bucketStart[b + 1];
+		for (unsigned int i = awake.bucketStart[b]; i < end; i++)
+		{
+			for (unsigned int j = i + 1; j < end; j++)
+			{
+				// different cells can share a bucket
+				if (awake.sorted[i].x == awake.sorted[j].x && awake.sorted[i].y == awake.sorted[j].y)
+					TestInCell(awake.sorted[i], awake.sorted[j], pairs);
+			}
+		}
+	}
+
+	// and against whatever's resting in the same cells
+	const Grid& resting = m_restingGrid;
+	for (auto& e1 : awake.entries)
+	{
+		unsigned int b = Hash(e1.x, e1.y, resting.tableSize);
+		for (unsigned int j = resting.bucketStart[b]; j < resting.bucketStart[b + 1]; j++)
+		{
+			if (e1.x == resting.sorted[j].x && e1.y == resting.sorted[j].y)
+				TestInCell(e1, resting.sorted[j], pairs);
+		}
+	}
+
+	// oversized awake bodies are tested against everything, and oversized resting ones against the awake
+	// bodies that aren't oversized themselves. Pairs of awake oversized bodies only get reported once
+	for (int i : awake.large)
+	{
+		for (int j = 0; j < count; j++)
+		{
+			if (j == i || (m_awake[j] && m_isLarge[j] && j < i))
+				continue;
+			if (m_aabbs[i].Overlaps(m_aabbs[j]) && CanCollide(m_bodies[i], m_bodies[j]))
+				pairs.push_back(MakePair(m_bodies[i], m_bodies[j]));
+		}
+	}
+	for (int i : resting.large)
+	{
+		for (int j : m_awakeBodies)
+		{
+			if (!m_isLarge[j] && m_aabbs[i].Overlaps(m_aabbs[j]) && CanCollide(m_bodies[i], m_bodies[j]))
+				pairs.push_back(MakePair(m_bodies[i], m_bodies[j]));
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include "Broadphase.h"
+
+// uniform grid broadphase. Every body is binned into the cells its AABB covers, and only bodies
+// sharing a cell are tested against each other. The cells are stored in a hash table built with a
+// counting sort, so there's no limit on the size of the world.
+//
+// Sleeping and fixed bodies don't move, so they go in a grid of their own that's only built again when
+// one of them wakes, something falls asleep, or a body is added or removed. Each step just bins the awake
+// bodies and tests them against each other and against the cells of the resting grid they cover.
+class SpatialHash : public Broadphase
+{
+public:
+	virtual BroadphaseType GetType() { return SPATIAL_HASH; }
+
+	virtual void AddBody(RigidBody* body);
+	virtual void RemoveBody(RigidBody* body);
+	virtual void FindPairs(std::vector<BroadphasePair>& pairs);
+
+	virtual void Query(const AABB& aabb, std::vector<RigidBody*>& results) { LinearQuery(m_bodies, aabb, results); }
+	virtual RigidBody* RayCast(glm::vec2 start, glm::vec2 end, float& fraction) { return LinearRayCast(m_bodies, start, end, fraction); }
+
+	// size of a grid cell. If zero, it's picked from the average size of the bodies whenever the resting grid is built
+	float cellSize = 0;
+
+	// bodies covering more cells than this are too big for the grid (long walls etc.)
+	// and are tested against every other body instead
+	int maxCellsPerBody = 64;
+
+	std::vector<RigidBody*> m_bodies;
+
+private:
+	struct Entry
+	{
+		int x, y;
+		int body;
+	};
+
+	// cell entries sorted into hash buckets, with the bodies too big to bin kept to one side
+	struct Grid
+	{
+		unsigned int tableSize = 0;
+		std::vector<Entry> entries;
+		std::vector<Entry> sorted;
+		std::vector<unsigned int> bucketStart;
+		std::vector<int> large;
+	};
+
+	int CellCoord(float v) { return (int)floorf(v * m_invCellSize); }
+	static unsigned int Hash(int x, int y, unsigned int tableSize) { return ((unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u) & (tableSize - 1); }
+
+	void Build(Grid& grid, const std::vector<int>& bodies);
+	// reports the pair if this cell holds the minimum corner of where the two overlap, so bodies sharing
+	// several cells only come up once
+	void TestInCell(const Entry& e1, const Entry& e2, std::vector<BroadphasePair>& pairs);
+
+	float m_invCellSize = 1;
+
+	// by index into m_bodies. Bodies that aren't awake keep the AABB they came to rest with
+	std::vector<AABB> m_aabbs;
+	std::vector<bool> m_awake;
+	std::vector<bool> m_isLarge;
+
+	std::vector<int> m_awakeBodies;
+	std::vector<int> m_restingBodies;
+	Grid m_awakeGrid;
+	Grid m_restingGrid;
+	// set when the resting bodies have changed and their grid needs building again
+	bool m_restingChanged = true;
+};
\ No newline at end of file
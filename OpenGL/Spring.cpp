@@ -1,18 +1,21 @@
-#include <gl_core_4_4.h>
-#include <glm\glm\glm.hpp>
-#include <aie/Gizmos.h>
+#include <glm/glm/glm.hpp>
 
 #include "Spring.h"
+#include "DebugDraw.h"
 
 void Spring::Update(float dt)
 {
+	// both ends are asleep, so it was at rest when they went to sleep. If one end's awake the force wakes the other
+	if (!body1->IsAwake() && !body2->IsAwake())
+		return;
+
 	glm::vec2 p2 = body2->ToWorld(contact2);
 	glm::vec2 p1 = body1->ToWorld(contact1);
 	glm::vec2 dist = p2 - p1;
 	float len = sqrtf(dist.x*dist.x + dist.y* dist.y);
 
 	// apply damping
-	glm::vec2 dv = body2->velocity - body1->velocity;
+	glm::vec2 dv = body2->Velocity() - body1->Velocity();
 
 	float damping = 0.1f;
 	glm::vec2 force = dist * restoringForce * (restLength - len) - damping * dv;
@@ -22,7 +25,7 @@ void Spring::Update(float dt)
 	body2->ApplyForce(force*dt, p2);
 }
 
-void Spring::Draw()
+void Spring::Draw(DebugDraw* draw)
 {
-	Gizmos::add2DLine(body1->ToWorld(contact1), body2->ToWorld(contact2), glm::vec4(1, 1, 1, 1));
-}
+	draw->add2DLine(body1->DrawToWorld(contact1), body2->DrawToWorld(contact2), glm::vec4(1, 1, 1, 1));
+}
\ No newline at end of file
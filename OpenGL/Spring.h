@@ -11,11 +11,7 @@ public:
 	RigidBody* body2;
 
 	virtual void Update(float dt);
-	virtual void Draw();
-
-	virtual void CollideWithPlane(Plane* plane) {};
-	virtual void CollideWithCircle(Circle* circle) {};	
-	virtual void CollideWithBox(Box* circle) {};
+	virtual void Draw(DebugDraw* draw);
 
 	glm::vec2 contact1;
 	glm::vec2 contact2;
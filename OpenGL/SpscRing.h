@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <vector>
+
+// a fixed size queue for one thread to push onto and one other thread to pop from, without locks. Each end only
+// writes its own index, and publishes it with a release store once the element it covers is written or read.
+template<class T>
+class SpscRing
+{
+public:
+	// capacity is rounded up to a power of two
+	SpscRing(unsigned int capacity = 1024)
+	{
+		unsigned int size = 1;
+		while (size < capacity)
+			size *= 2;
+		m_items.resize(size);
+		m_mask = size - 1;
+	}
+
+	SpscRing(const SpscRing&) = delete;
+	SpscRing& operator=(const SpscRing&) = delete;
+
+	// producer only. Returns false, leaving the ring as it was, if it's full
+	bool Push(const T& item)
+	{
+		unsigned int head = m_head.load(std::memory_order_relaxed);
+		if (head - m_tail.load(std::memory_order_acquire) > m_mask)
+			return false;
+		m_items[head & m_mask] = item;
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer only. Returns false if there's nothing to take
+	bool Pop(T& item)
+	{
+		unsigned int tail = m_tail.load(std::memory_order_relaxed);
+		if (tail == m_head.load(std::memory_order_acquire))
+			return false;
+		item = m_items[tail & m_mask];
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool Empty() const { return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire); }
+	unsigned int Capacity() const { return m_mask + 1; }
+
+private:
+	std::vector<T> m_items;
+	unsigned int m_mask;
+	// a cache line apart so the two threads aren't fighting over one line. Both only ever count up, wrapping
+	// round together, so head - tail is always how many items are in the ring. Padded rather than alignas(64),
+	// which would stop anything holding a ring, such as a PhysicsWorld, being made with new before C++17
+	std::atomic<unsigned int> m_head{ 0 };
+	char m_headPadding[64 - sizeof(std::atomic<unsigned int>)];
+	std::atomic<unsigned int> m_tail{ 0 };
+	char m_tailPadding[64 - sizeof(std::atomic<unsigned int>)];
+};
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include <glm/glm/glm.hpp>
+#include <algorithm>
+
+#include "SweepAndPrune.h"
+#include "RigidBody.h"
+
+void SweepAndPrune::AddBody(RigidBody* body)
+{
+	int proxy;
+	if (m_freeProxies.size() > 0)
+	{
+		proxy = m_freeProxies.back();
+		m_freeProxies.pop_back();
+	}
+	else
+	{
+		proxy = (int)m_proxies.size();
+		m_proxies.push_back(Proxy());
+	}
+	m_proxies[proxy].body = body;
+	m_proxies[proxy].aabb = body->GetAABB();
+	// counted as awake until the next step has had a look at it, so its bounds are taken from wherever it is by then
+	m_proxies[proxy].awake = true;
+	body->proxy = proxy;
+
+	// new endpoints go on the end, the next sort moves them into place and finds their overlaps
+	m_endpoints.push_back({ m_proxies[proxy].aabb.min.x, proxy, true });
+	m_endpoints.push_back({ m_proxies[proxy].aabb.max.x, proxy, false });
+	Track((int)m_endpoints.size() - 2);
+	Track((int)m_endpoints.size() - 1);
+	m_numAdded++;
+}
+
+void SweepAndPrune::RemoveBody(RigidBody* body)
+{
+	int proxy = body->proxy;
+
+	int dest = 0;
+	for (unsigned int i = 0; i < m_endpoints.size(); i++)
+	{
+		if (m_endpoints[i].proxy != proxy)
+		{
+			m_endpoints[dest] = m_endpoints[i];
+			Track(dest++);
+		}
+	}
+	m_endpoints.resize(dest);
+
+	for (int i = (int)m_overlaps.size() - 1; i >= 0; i--)
+	{
+		if (m_overlaps[i].a == proxy || m_overlaps[i].b == proxy)
+			RemovePair(m_overlaps[i].a, m_overlaps[i].b);
+	}
+
+	m_proxies[proxy].body = nullptr;
+	m_freeProxies.push_back(proxy);
+	body->proxy = -1;
+}
+
+unsigned long long SweepAndPrune::PairKey(int a, int b)
+{
+	if (a > b)
+		std::swap(a, b);
+	return ((unsigned long long)a << 32) | (unsigned int)b;
+}
+
+void SweepAndPrune::AddPair(int a, int b)
+{
+	unsigned long long key = PairKey(a, b);
+	if (m_overlapIndex.find(key) != m_overlapIndex.end())
+		return;
+	m_overlapIndex[key] = (int)m_overlaps.size();
+	m_overlaps.push_back({ a, b });
+}
+
+void SweepAndPrune::RemovePair(int a, int b)
+{
+	auto it = m_overlapIndex.find(PairKey(a, b));
+	if (it == m_overlapIndex.end())
+		return;
+
+	// swap the last pair into the hole
+	int index = it->second;
+	m_overlapIndex.erase(it);
+	if (index != (int)m_overlaps.size() - 1)
+	{
+		m_overlaps[index] = m_overlaps.back();
+		m_overlapIndex[PairKey(m_overlaps[index].a, m_overlaps[index].b)] = index;
+	}
+	m_overlaps.pop_back();
+}
+
+void SweepAndPrune::Track(int index)
+{
+	const Endpoint& e = m_endpoints[index];
+	if (e.isMin)
+		m_proxies[e.proxy].min = index;
+	else
+		m_proxies[e.proxy].max = index;
+}
+
+// touching boxes overlap, as they do for AABB::Overlaps(), so a min goes before a max at the same value
+bool SweepAndPrune::Precedes(const Endpoint& a, const Endpoint& b)
+{
+	if (a.value != b.value)
+		return a.value < b.value;
+	return a.isMin && !b.isMin;
+}
+
+// full sort and sweep, used when the endpoints are too far out of order for the insertion sort
+void SweepAndPrune::Rebuild()
+{
+	std::sort(m_endpoints.begin(), m_endpoints.end(), Precedes);
+	for (int i = 0; i < (int)m_endpoints.size(); i++)
+		Track(i);
+
+	m_overlaps.clear();
+	m_overlapIndex.clear();
+	m_active.clear();
+	for (auto& e : m_endpoints)
+	{
+		if (e.isMin)
+		{
+			for (int other : m_active)
+				AddPair(e.proxy, other);
+			m_active.push_back(e.proxy);
+		}
+		else
+		{
+			m_active.erase(std::find(m_active.begin(), m_active.end(), e.proxy));
+		}
+	}
+}
+
+void SweepAndPrune::FindPairs(std::vector<BroadphasePair>& pairs)
+{
+	// only awake bodies have moved. One that's just stopped is looked at once more, to get where it came to rest
+	for (auto& proxy : m_proxies)
+	{
+		if (!proxy.body)
+			continue;
+		bool awake = proxy.body->IsAwake();
+		if (!awake && !proxy.awake)
+			continue;
+		proxy.awake = awake;
+		proxy.aabb = proxy.body->GetAABB();
+		m_endpoints[proxy.min].value = proxy.aabb.min.x;
+		m_endpoints[proxy.max].value = proxy.aabb.max.x;
+	}
+
+	int count = (int)m_endpoints.size();
+	if (m_numAdded * 8 > count)
+		Rebuild();
+	m_numAdded = 0;
+
+	// insertion sort, starting or ending an overlap whenever a min and max swap over
+	for (int i = 1; i < count; i++)
+	{
+		int j = i - 1;
+		if (!Precedes(m_endpoints[i], m_endpoints[j]))
+			continue;
+		Endpoint key = m_endpoints[i];
+		while (j >= 0 && Precedes(key, m_endpoints[j]))
+		{
+			const Endpoint& other = m_endpoints[j];
+			if (key.isMin && !other.isMin)
+				AddPair(key.proxy, other.proxy);
+			else if (!key.isMin && other.isMin)
+				RemovePair(key.proxy, other.proxy);
+			m_endpoints[j + 1] = m_endpoints[j];
+			Track(j + 1);
+			j--;
+		}
+		m_endpoints[j + 1] = key;
+		Track(j + 1);
+	}
+
+	// anything overlapping on x just needs checking on y
+	for (auto& overlap : m_overlaps)
+	{
+		Proxy& a = m_proxies[overlap.a];
+		Proxy& b = m_proxies[overlap.b];
+		if (a.aabb.Overlaps(b.aabb) && CanCollide(a.body, b.body))
+			pairs.push_back(MakePair(a.body, b.body));
+	}
+}
+
+void SweepAndPrune::Query(const AABB& aabb, std::vector<RigidBody*>& results)
+{
+	for (auto& proxy : m_proxies)
+	{
+		if (proxy.body && proxy.aabb.Overlaps(aabb))
+			results.push_back(proxy.body);
+	}
+}
+
+RigidBody* SweepAndPrune::RayCast(glm::vec2 start, glm::vec2 end, float& fraction)
+{
+	RigidBody* hit = nullptr;
+	fraction = 1;
+	for (auto& proxy : m_proxies)
+	{
+		float t;
+		if (proxy.body && RayHitsAABB(proxy.aabb, start, end, fraction, t) && proxy.body->RayCast(start, end, t) && t < fraction)
+		{
+			fraction = t;
+			hit = proxy.body;
+		}
+	}
+	return hit;
+}
\ No newline at end of file
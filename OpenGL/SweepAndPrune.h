@@ -0,0 +1,68 @@
+#pragma once
+#include <unordered_map>
+
+#include "Broadphase.h"
+
+// incremental sort and sweep along the x axis. The endpoint array is kept sorted between steps with
+// an insertion sort, which is close to linear when bodies only move a little each step. Every swap of
+// a min past a max starts or ends an overlap on x, so the set of overlapping pairs is kept up to date
+// as a side effect of the sort rather than being rebuilt. Sleeping and fixed bodies don't move, so only the
+// awake bodies' bounds are refreshed, and the sort just passes over everything else.
+class SweepAndPrune : public Broadphase
+{
+public:
+	virtual BroadphaseType GetType() { return SWEEP_AND_PRUNE; }
+
+	virtual void AddBody(RigidBody* body);
+	virtual void RemoveBody(RigidBody* body);
+	virtual void FindPairs(std::vector<BroadphasePair>& pairs);
+
+	virtual void Query(const AABB& aabb, std::vector<RigidBody*>& results);
+	virtual RigidBody* RayCast(glm::vec2 start, glm::vec2 end, float& fraction);
+
+private:
+	struct Endpoint
+	{
+		float value;
+		int proxy;
+		bool isMin;
+	};
+
+	struct Proxy
+	{
+		RigidBody* body;
+		AABB aabb;
+		// where its endpoints are in m_endpoints
+		int min, max;
+		// as of the last FindPairs()
+		bool awake;
+	};
+
+	// pair of proxies overlapping on the x axis
+	struct OverlapPair
+	{
+		int a, b;
+	};
+
+	static bool Precedes(const Endpoint& a, const Endpoint& b);
+	void Rebuild();
+	// points the endpoint's proxy back at where it now is
+	void Track(int index);
+
+	static unsigned long long PairKey(int a, int b);
+	void AddPair(int a, int b);
+	void RemovePair(int a, int b);
+
+	std::vector<Proxy> m_proxies;
+	std::vector<int> m_freeProxies;
+
+	std::vector<Endpoint> m_endpoints;
+
+	// bodies added since the last step. If there are a lot of them it's quicker to start again than insertion sort
+	int m_numAdded = 0;
+	std::vector<int> m_active;
+
+	// persistent set of x overlaps, with a map from pair key to index so they can be removed quickly
+	std::vector<OverlapPair> m_overlaps;
+	std::unordered_map<unsigned long long, int> m_overlapIndex;
+};
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include <chrono>
+
+#include "Telemetry.h"
+
+// how long the writer sleeps when it's caught up
+static const int WRITER_SLEEP_MS = 2;
+
+bool Telemetry::Start(const char* path, Format format)
+{
+	Stop();
+
+	m_file = fopen(path, format == BINARY ? "wb" : "w");
+	if (!m_file)
+		return false;
+
+	m_format = format;
+	m_dropped = 0;
+	m_stop = false;
+
+	if (format == BINARY)
+	{
+		int header[3] = { BINARY_MAGIC, BINARY_VERSION, (int)sizeof(TelemetrySample) };
+		fwrite(header, sizeof(header), 1, m_file);
+	}
+	else
+		fprintf(m_file, "step,time,kinetic,potential,rotational,total,bodies,awake,pairs,contacts,particles\n");
+
+	m_writer = std::thread(&Telemetry::WriterMain, this);
+	return true;
+}
+
+void Telemetry::Stop()
+{
+	if (!m_file)
+		return;
+
+	m_stop = true;
+	m_writer.join();
+	fclose(m_file);
+	m_file = nullptr;
+}
+
+void Telemetry::Record(const TelemetrySample& sample)
+{
+	if (!m_ring.Push(sample))
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Telemetry::WriterMain()
+{
+	TelemetrySample sample;
+	for (;;)
+	{
+		// read the flag before draining, so anything pushed before Stop() set it is still written
+		bool stop = m_stop;
+		while (m_ring.Pop(sample))
+			Write(sample);
+		if (stop)
+			break;
+
+		fflush(m_file);
+		std::this_thread::sleep_for(std::chrono::milliseconds(WRITER_SLEEP_MS));
+	}
+}
+
+void Telemetry::Write(const TelemetrySample& sample)
+{
+	if (m_format == BINARY)
+	{
+		fwrite(&sample, sizeof(sample), 1, m_file);
+		return;
+	}
+
+	fprintf(m_file, "%d,%.4f,%.4f,%.4f,%.4f,%.4f,%d,%d,%d,%d,%d\n", sample.step, sample.time,
+		sample.kinetic, sample.potential, sample.rotational, sample.kinetic + sample.potential + sample.rotational,
+		sample.bodies, sample.awake, sample.pairs, sample.contacts, sample.particles);
+}
\ No newline at end of file
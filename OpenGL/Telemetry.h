@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+
+#include "SpscRing.h"
+
+// the world's vital signs after one step
+struct TelemetrySample
+{
+	int step;
+	float time;
+	float kinetic, potential, rotational;
+	int bodies, awake;
+	int pairs, contacts;
+	int particles;
+};
+
+// writes TelemetrySamples to a file without holding up the thread that steps the world. Samples go into a lock free
+// ring and a background thread takes them out and writes them, so the step never waits on the disk or the console.
+// If the writer falls so far behind that the ring fills up, samples are dropped and counted rather than waited for.
+class Telemetry
+{
+public:
+	enum Format
+	{
+		// a header line, then one line per sample
+		CSV,
+		// BINARY_MAGIC, BINARY_VERSION and sizeof(TelemetrySample) as three 32 bit ints, then the samples as they are in memory
+		BINARY,
+	};
+
+	enum { BINARY_MAGIC = 0x4c455450, BINARY_VERSION = 1 };
+
+	Telemetry() {}
+	~Telemetry() { Stop(); }
+	Telemetry(const Telemetry&) = delete;
+	Telemetry& operator=(const Telemetry&) = delete;
+
+	// opens the file and starts the writer. Returns false if the file can't be opened
+	bool Start(const char* path, Format format);
+	// writes out whatever is still in the ring and closes the file
+	void Stop();
+	bool IsRunning() { return m_file != nullptr; }
+
+	// whether the given step is one that should be sampled
+	bool WantsSample(int step) { return m_file && sampleInterval > 0 && step % sampleInterval == 0; }
+	// from the stepping thread only
+	void Record(const TelemetrySample& sample);
+
+	// samples lost because the ring was full
+	int Dropped() { return m_dropped.load(std::memory_order_relaxed); }
+
+	// steps between samples. Set before or after Start()
+	int sampleInterval = 1;
+
+private:
+	void WriterMain();
+	void Write(const TelemetrySample& sample);
+
+	SpscRing<TelemetrySample> m_ring{ 4096 };
+	std::thread m_writer;
+	std::atomic<bool> m_stop{ false };
+	std::atomic<int> m_dropped{ 0 };
+	FILE* m_file = nullptr;
+	Format m_format = CSV;
+};
\ No newline at end of file